@@ -13,6 +13,9 @@ Magic RookMagics[64];
 Bitboard BishopTable[0x1480];
 Bitboard RookTable[0x19000];
 
+Bitboard BetweenBB[64][64];
+Bitboard LineBB[64][64];
+
 // Magic numbers generated for this engine's square mapping and occupancy masks.
 static constexpr Bitboard BishopMagicNumbers[64] = {
     0x40045002080b1010ULL, 0x805430ac0100a010ULL, 0x12440042000000ULL,   0x8060148108000ULL,
@@ -171,6 +174,27 @@ static void init_magics(Magic* magics, Bitboard* table, const Bitboard* magic_nu
     }
 }
 
+static void init_lines() {
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            BetweenBB[a][b] = 0;
+            LineBB[a][b] = 0;
+            if (a == b)
+                continue;
+
+            Square sa = Square(a), sb = Square(b);
+            Bitboard bbA = square_bb(sa), bbB = square_bb(sb);
+            if (RookMagics[a](0) & bbB) {
+                LineBB[a][b] = (RookMagics[a](0) & RookMagics[b](0)) | bbA | bbB;
+                BetweenBB[a][b] = RookMagics[a](bbB) & RookMagics[b](bbA);
+            } else if (BishopMagics[a](0) & bbB) {
+                LineBB[a][b] = (BishopMagics[a](0) & BishopMagics[b](0)) | bbA | bbB;
+                BetweenBB[a][b] = BishopMagics[a](bbB) & BishopMagics[b](bbA);
+            }
+        }
+    }
+}
+
 Bitboard bishop_attacks(Square s, Bitboard occ) {
     return BishopMagics[s](occ);
 }
@@ -185,6 +209,7 @@ void init() {
     init_king_attacks();
     init_magics(BishopMagics, BishopTable, BishopMagicNumbers, true);
     init_magics(RookMagics, RookTable, RookMagicNumbers, false);
+    init_lines();
 }
 
 }  // namespace attacks
@@ -31,6 +31,12 @@ extern Magic RookMagics[64];
 extern Bitboard BishopTable[0x1480];
 extern Bitboard RookTable[0x19000];
 
+// Line geometry tables (filled by init() after the magics)
+// BetweenBB[a][b]: squares strictly between a and b when they share a rank, file or diagonal.
+// LineBB[a][b]: the full board-edge-to-edge line through a and b, or 0 if not aligned.
+extern Bitboard BetweenBB[64][64];
+extern Bitboard LineBB[64][64];
+
 // Lookup functions
 inline Bitboard pawn_attacks(Color c, Square s) {
     return PawnAttacks[c][s];
@@ -46,6 +52,12 @@ Bitboard rook_attacks(Square s, Bitboard occ);
 inline Bitboard queen_attacks(Square s, Bitboard occ) {
     return bishop_attacks(s, occ) | rook_attacks(s, occ);
 }
+inline Bitboard between_bb(Square a, Square b) {
+    return BetweenBB[a][b];
+}
+inline Bitboard line_bb(Square a, Square b) {
+    return LineBB[a][b];
+}
 
 void init();
 
@@ -0,0 +1,117 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <vector>
+
+#include "board.h"
+#include "eval.h"
+#include "nnue/panda_nnue.h"
+#include "search.h"
+#include "search_stats.h"
+#include "tt.h"
+
+namespace panda {
+
+static constexpr int DEFAULT_HASH_MB = 16;
+static constexpr int DEFAULT_THREADS = 1;
+static constexpr int DEFAULT_DEPTH = 7;
+
+// Silver suite openings, then middlegames and endgames with tactics, castling rights,
+// promotions and en passant.
+static const char* BENCH_FENS[] = {
+    "r1bq1rk1/pp2ppbp/2n2np1/2ppN3/5P2/1P2P3/PBPPB1PP/RN1Q1RK1 b - - 3 8",
+    "rnbqkb1r/pp3p1p/3p1np1/2pP4/4P3/2N5/PP3PPP/R1BQKBNR w KQkq - 0 7",
+    "rnbq1rk1/pp2ppbp/2pp1np1/8/3PP3/2N2N2/PPP1BPPP/R1BQ1RK1 w - - 0 7",
+    "rnb1kb1r/pp3ppp/4pn2/2pq4/3P4/2P2N2/PP3PPP/RNBQKB1R w KQkq - 0 6",
+    "r1bqkb1r/1p3pp1/p1nppn1p/6B1/3NP3/2N5/PPPQ1PPP/2KR1B1R w kq - 0 9",
+    "r1bqkb1r/pp1n1ppp/2n1p3/2ppP3/3P4/2PB4/PP1N1PPP/R1BQK1NR w KQkq - 2 7",
+    "r1bqk2r/1pp2ppp/pbnp1n2/4p3/PPB1P3/2PP1N2/5PPP/RNBQK2R w KQkq - 0 8",
+    "rnbq1rk1/ppp1ppbp/6p1/3n4/3P4/5NP1/PP2PPBP/RNBQ1RK1 b - - 1 7",
+    "rnbq1rk1/pppp1ppp/4pn2/8/2PP4/P1Q5/1P2PPPP/R1B1KBNR b KQ - 0 6",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r2q1rk1/pp2bppp/2n1bn2/2pp4/3P4/2NBPN2/PP3PPP/R1BQ1RK1 w - - 0 9",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "2r3k1/1p3ppp/p3p3/3pP3/3P4/P1R2N2/1P3PPP/6K1 b - - 0 25",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/1p2k3/p1p1p3/P1P1P3/1P2K3/8/8 w - - 0 1",
+    "8/3k4/8/8/2Q5/8/4K3/8 w - - 0 1",
+};
+
+uint64_t bench(std::istream& args, std::ostream& out) {
+    int hashMB = DEFAULT_HASH_MB;
+    int threads = DEFAULT_THREADS;
+    int depth = DEFAULT_DEPTH;
+    if (!(args >> hashMB))
+        hashMB = DEFAULT_HASH_MB;
+    else if (!(args >> threads))
+        threads = DEFAULT_THREADS;
+    else if (!(args >> depth))
+        depth = DEFAULT_DEPTH;
+    hashMB = std::clamp(hashMB, 1, 4096);
+    threads = std::clamp(threads, 1, 256);
+    depth = std::clamp(depth, 1, MAX_PLY);
+
+    // Load the nets before the clock starts
+    if (get_eval_mode() == EvalMode::NNUE)
+        nnue::preallocate_contexts(threads);
+
+    out << "bench: hash " << hashMB << " MB, threads " << threads << ", depth " << depth
+        << ", eval " << eval_mode_name(get_eval_mode()) << std::endl;
+
+    // The positions are searched like the moves of one game: history carries over between
+    // them but starts empty, so the signature does not depend on earlier searches. The pool is
+    // given back at its configured size.
+    const int configuredThreads = search_threads();
+    clear_search_heuristics();
+    reset_search_stats();
+    TranspositionTable tt(static_cast<size_t>(hashMB), threads);
+    std::atomic<bool> stopFlag{false};
+    const int positionCount = static_cast<int>(std::size(BENCH_FENS));
+    uint64_t totalNodes = 0;
+    int64_t totalMs = 0;
+
+    for (int i = 0; i < positionCount; ++i) {
+        Board board;
+        board.set_fen(BENCH_FENS[i]);
+        tt.clear(threads);
+
+        // A threaded search raises the flag to stop its helpers when it finishes
+        stopFlag.store(false, std::memory_order_relaxed);
+
+        uint64_t nodes = 0;
+        auto infoCb = [&nodes](const SearchInfo& info) { nodes = info.nodes; };
+        auto start = std::chrono::steady_clock::now();
+        SearchResult result = search(board, TimeLimits{}, depth, tt, stopFlag,
+                                     {board.hash_key()}, threads, infoCb);
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+        totalNodes += nodes;
+        totalMs += ms;
+        out << "Position " << (i + 1) << "/" << positionCount << ": " << nodes << " nodes, " << ms
+            << " ms, bestmove " << move_to_uci(result.bestMove) << "  (" << BENCH_FENS[i] << ")"
+            << std::endl;
+    }
+
+    if (threads != configuredThreads)
+        set_search_threads(configuredThreads);
+
+    out << "===========================" << std::endl;
+    out << "Total time (ms) : " << totalMs << std::endl;
+    out << "Nodes searched  : " << totalNodes << std::endl;
+    out << "Nodes/second    : " << totalNodes * 1000 / uint64_t(std::max<int64_t>(totalMs, 1))
+        << std::endl;
+    if (SEARCH_STATS_ENABLED)
+        print_search_stats(search_stats_totals(), out);
+    return totalNodes;
+}
+
+}  // namespace panda
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace panda {
+
+// Searches a fixed set of positions to a fixed depth and prints the time and node count of
+// each. The total node count is a signature of the search: any change to search or
+// evaluation behaviour changes it, while pure speed-ups only change the NPS. The signature
+// is deterministic with one thread only.
+//
+// Arguments, all optional: hash size in MB (default 16), threads (1), depth (7).
+uint64_t bench(std::istream& args, std::ostream& out);
+
+}  // namespace panda
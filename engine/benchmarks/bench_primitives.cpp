@@ -0,0 +1,255 @@
+// Microbenchmarks of the primitives the search spends its time in. Run with
+// --benchmark_format=json (or --benchmark_out=<file> --benchmark_out_format=json) to get
+// results that can be compared across commits and hosts.
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "../attacks.h"
+#include "../board.h"
+#include "../eval.h"
+#include "../move.h"
+#include "../movegen.h"
+#include "../nnue/panda_nnue.h"
+#include "../search.h"
+#include "../tt.h"
+#include "../zobrist.h"
+#include "panda_revision.h"
+
+using namespace panda;
+
+// Opening, middlegame and endgame positions; every benchmark loops over all of them so one
+// position's quirks do not dominate.
+static const char* BENCH_POSITIONS[] = {
+    StartFEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r2q1rk1/pp2bppp/2n1bn2/2pp4/3P4/2NBPN2/PP3PPP/R1BQ1RK1 w - - 0 9",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "2r3k1/1p3ppp/p3p3/3pP3/3P4/P1R2N2/1P3PPP/6K1 b - - 0 25",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/1p2k3/p1p1p3/P1P1P3/1P2K3/8/8 w - - 0 1",
+};
+
+static std::vector<Board> benchBoards() {
+    std::vector<Board> boards;
+    for (const char* fen : BENCH_POSITIONS) {
+        Board board;
+        board.set_fen(fen);
+        boards.push_back(board);
+    }
+    return boards;
+}
+
+// Every (square, occupancy) pair that occurs for the sliders of the bench positions.
+struct SliderQuery {
+    Square square;
+    Bitboard occupied;
+};
+
+static std::vector<SliderQuery> sliderQueries(PieceType slider) {
+    std::vector<SliderQuery> queries;
+    for (const Board& board : benchBoards()) {
+        for (Color c : {White, Black}) {
+            Bitboard sliders = board.pieces(c, slider) | board.pieces(c, Queen);
+            while (sliders) {
+                Square sq = pop_lsb(sliders);
+                queries.push_back({sq, board.all_pieces()});
+            }
+        }
+    }
+    return queries;
+}
+
+// ============================================================
+// Attacks
+// ============================================================
+
+static void BM_BishopAttacks(benchmark::State& state) {
+    const std::vector<SliderQuery> queries = sliderQueries(Bishop);
+    for (auto _ : state) {
+        for (const SliderQuery& q : queries)
+            benchmark::DoNotOptimize(attacks::bishop_attacks(q.square, q.occupied));
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(queries.size()));
+}
+BENCHMARK(BM_BishopAttacks);
+
+static void BM_RookAttacks(benchmark::State& state) {
+    const std::vector<SliderQuery> queries = sliderQueries(Rook);
+    for (auto _ : state) {
+        for (const SliderQuery& q : queries)
+            benchmark::DoNotOptimize(attacks::rook_attacks(q.square, q.occupied));
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(queries.size()));
+}
+BENCHMARK(BM_RookAttacks);
+
+// ============================================================
+// Board and move generation
+// ============================================================
+
+static void BM_MakeUnmake(benchmark::State& state) {
+    std::vector<Board> boards = benchBoards();
+    std::vector<MoveList> moves;
+    int64_t moveCount = 0;
+    for (const Board& board : boards) {
+        moves.push_back(generate_legal(board));
+        moveCount += moves.back().size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < boards.size(); ++i) {
+            for (Move m : moves[i]) {
+                Board::UndoInfo undo;
+                boards[i].make_move(m, undo);
+                boards[i].unmake_move(m, undo);
+            }
+            benchmark::DoNotOptimize(boards[i].hash_key());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * moveCount);
+}
+BENCHMARK(BM_MakeUnmake);
+
+static void BM_GenerateLegal(benchmark::State& state) {
+    const std::vector<Board> boards = benchBoards();
+    for (auto _ : state) {
+        for (const Board& board : boards) {
+            MoveList moves = generate_legal(board);
+            benchmark::DoNotOptimize(moves.count);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(boards.size()));
+}
+BENCHMARK(BM_GenerateLegal);
+
+// ============================================================
+// Search helpers
+// ============================================================
+
+static void BM_StaticExchangeEval(benchmark::State& state) {
+    struct Capture {
+        const Board* board;
+        Move move;
+    };
+    const std::vector<Board> boards = benchBoards();
+    std::vector<Capture> captures;
+    for (const Board& board : boards) {
+        for (Move m : generate_legal(board, GenType::Captures)) captures.push_back({&board, m});
+    }
+
+    for (auto _ : state) {
+        for (const Capture& c : captures)
+            benchmark::DoNotOptimize(staticExchangeEvalForTests(*c.board, c.move));
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(captures.size()));
+}
+BENCHMARK(BM_StaticExchangeEval);
+
+static void BM_EvaluateHandcrafted(benchmark::State& state) {
+    const std::vector<Board> boards = benchBoards();
+    for (auto _ : state) {
+        for (const Board& board : boards) benchmark::DoNotOptimize(evaluate_handcrafted(board));
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(boards.size()));
+}
+BENCHMARK(BM_EvaluateHandcrafted);
+
+// ============================================================
+// Transposition table
+// ============================================================
+
+// Random keys over a table larger than the caches, as in a real search
+static constexpr size_t TT_BENCH_MB = 64;
+static constexpr size_t TT_BENCH_KEYS = 1 << 16;
+
+static std::vector<uint64_t> randomKeys() {
+    std::mt19937_64 rng(0x5EED);
+    std::vector<uint64_t> keys(TT_BENCH_KEYS);
+    for (uint64_t& key : keys) key = rng();
+    return keys;
+}
+
+static void BM_TTStore(benchmark::State& state) {
+    TranspositionTable tt(TT_BENCH_MB);
+    const std::vector<uint64_t> keys = randomKeys();
+    int depth = 0;
+    for (auto _ : state) {
+        for (uint64_t key : keys) tt.store(key, 0, depth, TT_EXACT, NullMove);
+        depth = (depth + 1) % 32;
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(keys.size()));
+}
+BENCHMARK(BM_TTStore);
+
+static void BM_TTProbe(benchmark::State& state) {
+    TranspositionTable tt(TT_BENCH_MB);
+    const std::vector<uint64_t> keys = randomKeys();
+    // Half the probes hit
+    for (size_t i = 0; i < keys.size(); i += 2) tt.store(keys[i], 0, 1, TT_EXACT, NullMove);
+
+    for (auto _ : state) {
+        for (uint64_t key : keys) {
+            TTEntry entry;
+            benchmark::DoNotOptimize(tt.probe(key, entry));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(keys.size()));
+}
+BENCHMARK(BM_TTProbe);
+
+// ============================================================
+// NNUE
+// ============================================================
+
+// One incremental accumulator update and a forward pass per legal move, as at a search node.
+static void BM_NnueUpdateEvaluate(benchmark::State& state) {
+    nnue::SearchNnueContext ctx;
+    if (!ctx.is_available()) {
+        state.SkipWithError("NNUE nets are not loaded");
+        return;
+    }
+
+    std::vector<Board> boards = benchBoards();
+    std::vector<MoveList> moves;
+    int64_t moveCount = 0;
+    for (const Board& board : boards) {
+        moves.push_back(generate_legal(board));
+        moveCount += moves.back().size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < boards.size(); ++i) {
+            Board& board = boards[i];
+            ctx.reset(board);
+            for (Move m : moves[i]) {
+                Board::UndoInfo undo;
+                board.make_move(m, undo);
+                ctx.on_make_move(board, m, undo.nnueDirtyPiece, undo.nnueDirtyThreats);
+                benchmark::DoNotOptimize(ctx.evaluate(board));
+                board.unmake_move(m, undo);
+                ctx.on_unmake_move(board);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * moveCount);
+}
+BENCHMARK(BM_NnueUpdateEvaluate);
+
+int main(int argc, char** argv) {
+    attacks::init();
+    zobrist::init();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::AddCustomContext("panda_revision", PANDA_GIT_REVISION);
+    benchmark::AddCustomContext("panda_build_type", PANDA_BUILD_TYPE);
+    benchmark::AddCustomContext("nnue_kernel", nnue::kernel_name());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
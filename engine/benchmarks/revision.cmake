@@ -0,0 +1,11 @@
+# Writes the current git revision into OUTPUT. Run on every build by the panda_bench_revision
+# target; configure_file leaves the header untouched when the revision has not changed, so
+# panda-bench is only recompiled after a commit.
+execute_process(COMMAND ${GIT_EXECUTABLE} describe --always --dirty
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE PANDA_GIT_REVISION OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET)
+if(NOT PANDA_GIT_REVISION)
+    set(PANDA_GIT_REVISION "unknown")
+endif()
+configure_file(${INPUT} ${OUTPUT} @ONLY)
@@ -63,10 +63,6 @@ void Board::clear() {
     hash = 0;
 }
 
-Piece Board::piece_on(Square s) const {
-    return mailbox[s];
-}
-
 void Board::put_piece(Piece p, Square s) {
     assert(p < PieceCount);
     assert(mailbox[s] == NoPiece);
@@ -342,6 +338,44 @@ static constexpr CastlingRights CastlingUpdate[64] = {
     CastlingRights(~BlackKingSide & 0xF),
 };
 
+uint64_t Board::key_after(Move m) const {
+    Square from = move_from(m);
+    Square to = move_to(m);
+    MoveType mt = move_type(m);
+    Piece moved = mailbox[from];
+    Piece captured = mailbox[to];
+
+    uint64_t key = hash ^ zobrist::sideKey;
+    key ^= zobrist::pieceKeys[moved][from];
+
+    CastlingRights newCastling = castling & CastlingUpdate[from] & CastlingUpdate[to];
+    key ^= zobrist::castlingKeys[castling] ^ zobrist::castlingKeys[newCastling];
+    if (epSquare != NoSquare)
+        key ^= zobrist::enPassantKeys[square_file(epSquare)];
+
+    if (mt == EnPassant) {
+        Square capSq = make_square(square_file(to), square_rank(from));
+        key ^= zobrist::pieceKeys[mailbox[capSq]][capSq];
+        key ^= zobrist::pieceKeys[moved][to];
+    } else if (mt == Castling) {
+        key ^= zobrist::pieceKeys[moved][to];
+        Square rookFrom = make_square(to > from ? 7 : 0, square_rank(from));
+        Square rookTo = make_square(to > from ? 5 : 3, square_rank(from));
+        Piece rook = mailbox[rookFrom];
+        key ^= zobrist::pieceKeys[rook][rookFrom] ^ zobrist::pieceKeys[rook][rookTo];
+    } else {
+        if (captured != NoPiece)
+            key ^= zobrist::pieceKeys[captured][to];
+        Piece placed = (mt == Promotion) ? make_piece(sideToMove, promotion_type(m)) : moved;
+        key ^= zobrist::pieceKeys[placed][to];
+
+        // Double pawn push sets the en passant square
+        if (piece_type(moved) == Pawn && (to - from == 16 || from - to == 16))
+            key ^= zobrist::enPassantKeys[square_file(to)];
+    }
+    return key;
+}
+
 void Board::make_move(Move m) {
     UndoInfo undo;
     make_move(m, undo);
@@ -36,7 +36,9 @@ class Board {
     std::string to_fen() const;
 
     // Piece manipulation
-    Piece piece_on(Square s) const;
+    Piece piece_on(Square s) const {
+        return mailbox[s];
+    }
     void put_piece(Piece p, Square s);
     void remove_piece(Square s);
 
@@ -82,6 +84,10 @@ class Board {
     // Attack detection
     bool is_square_attacked(Square s, Color attacker) const;
 
+    // Zobrist key of the position after `m`, without making it. Lets search start the
+    // child's TT fetch before paying for make_move and the NNUE update.
+    uint64_t key_after(Move m) const;
+
     // Make a move on the board (modifies in place)
     void make_move(Move m);
     void make_move(Move m, UndoInfo& undo);
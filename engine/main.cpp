@@ -1,6 +1,37 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "attacks.h"
+#include "bench.h"
+#include "board.h"
+#include "perft.h"
 #include "uci.h"
+#include "zobrist.h"
+
+int main(int argc, char** argv) {
+    // "panda-chess bench [hash] [threads] [depth]" runs the benchmark without a GUI
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        panda::attacks::init();
+        panda::zobrist::init();
+        std::stringstream args;
+        for (int i = 2; i < argc; ++i) args << argv[i] << ' ';
+        panda::bench(args, std::cout);
+        return 0;
+    }
+
+    // "panda-chess perft|divide <depth> [threads] [hash] [full] [fen <fen>]", startpos default
+    if (argc > 1 && (std::string(argv[1]) == "perft" || std::string(argv[1]) == "divide")) {
+        panda::attacks::init();
+        panda::zobrist::init();
+        std::stringstream args;
+        for (int i = 2; i < argc; ++i) args << argv[i] << ' ';
+        panda::Board board;
+        board.set_fen(panda::StartFEN);
+        panda::perft_command(board, args, std::cout, std::string(argv[1]) == "divide");
+        return 0;
+    }
 
-int main() {
     panda::uci_loop();
     return 0;
 }
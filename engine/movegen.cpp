@@ -1,59 +1,187 @@
 #include "movegen.h"
 
+#include <cassert>
+
 #include "attacks.h"
 
 namespace panda {
 
-static void generate_pawn_moves(const Board& board, MoveList& moves) {
-    Color us = board.side_to_move();
-    Color them = ~us;
-    Bitboard own = board.pieces(us);
+// Per-node legality data, computed once before any move is emitted.
+// Every generator below only produces moves that leave our king safe.
+struct LegalityInfo {
+    Color us;
+    Color them;
+    Square kingSq;
+    Bitboard checkers;   // enemy pieces giving check
+    Bitboard pinned;     // our pieces pinned to our king
+    Bitboard danger;     // squares attacked by the enemy with our king lifted off the board
+    Bitboard checkMask;  // non-king moves must land here (all squares when not in check)
+};
+
+static Bitboard attackers_to(const Board& board, Square s, Color attacker, Bitboard occ) {
+    return (attacks::pawn_attacks(~attacker, s) & board.pieces(attacker, Pawn)) |
+           (attacks::knight_attacks(s) & board.pieces(attacker, Knight)) |
+           (attacks::king_attacks(s) & board.pieces(attacker, King)) |
+           (attacks::bishop_attacks(s, occ) &
+            (board.pieces(attacker, Bishop) | board.pieces(attacker, Queen))) |
+           (attacks::rook_attacks(s, occ) &
+            (board.pieces(attacker, Rook) | board.pieces(attacker, Queen)));
+}
+
+static Bitboard attacked_squares(const Board& board, Color attacker, Bitboard occ) {
+    Bitboard attacked = 0;
+
+    Bitboard pawns = board.pieces(attacker, Pawn);
+    if (attacker == White)
+        attacked |= ((pawns & ~FileMask[0]) << 7) | ((pawns & ~FileMask[7]) << 9);
+    else
+        attacked |= ((pawns & ~FileMask[7]) >> 7) | ((pawns & ~FileMask[0]) >> 9);
+
+    Bitboard knights = board.pieces(attacker, Knight);
+    while (knights) attacked |= attacks::knight_attacks(pop_lsb(knights));
+
+    Bitboard diagonal = board.pieces(attacker, Bishop) | board.pieces(attacker, Queen);
+    while (diagonal) attacked |= attacks::bishop_attacks(pop_lsb(diagonal), occ);
+
+    Bitboard straight = board.pieces(attacker, Rook) | board.pieces(attacker, Queen);
+    while (straight) attacked |= attacks::rook_attacks(pop_lsb(straight), occ);
+
+    attacked |= attacks::king_attacks(lsb(board.pieces(attacker, King)));
+    return attacked;
+}
+
+static LegalityInfo compute_legality(const Board& board) {
+    LegalityInfo info;
+    info.us = board.side_to_move();
+    info.them = ~info.us;
+    info.kingSq = lsb(board.pieces(info.us, King));
+
+    Bitboard occ = board.all_pieces();
+    info.checkers = attackers_to(board, info.kingSq, info.them, occ);
+
+    // Sliding attackers are computed without our king so it cannot "hide" behind itself
+    // by stepping along the checking ray.
+    info.danger = attacked_squares(board, info.them, occ ^ square_bb(info.kingSq));
+
+    info.pinned = 0;
+    Bitboard snipers =
+        (attacks::rook_attacks(info.kingSq, 0) &
+         (board.pieces(info.them, Rook) | board.pieces(info.them, Queen))) |
+        (attacks::bishop_attacks(info.kingSq, 0) &
+         (board.pieces(info.them, Bishop) | board.pieces(info.them, Queen)));
+    while (snipers) {
+        Square sniper = pop_lsb(snipers);
+        Bitboard blockers = attacks::between_bb(info.kingSq, sniper) & occ;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & board.pieces(info.us)))
+            info.pinned |= blockers;
+    }
+
+    if (info.checkers == 0) {
+        info.checkMask = ~Bitboard(0);
+    } else {
+        Square checker = lsb(info.checkers);
+        info.checkMask = info.checkers | attacks::between_bb(info.kingSq, checker);
+    }
+    return info;
+}
+
+// A pinned piece may only move along the line through its square and our king.
+static bool pin_allows(const LegalityInfo& info, Square from, Square to) {
+    return !(info.pinned & square_bb(from)) ||
+           (attacks::line_bb(info.kingSq, from) & square_bb(to));
+}
+
+// En passant removes two pieces from one rank, so it is checked directly against the
+// resulting occupancy instead of through the pin/check masks.
+static bool en_passant_is_legal(const Board& board, const LegalityInfo& info, Square from,
+                                Square to) {
+    Square capSq = make_square(square_file(to), square_rank(from));
+    Bitboard occ = (board.all_pieces() ^ square_bb(from) ^ square_bb(capSq)) | square_bb(to);
+    Bitboard enemyPawns = board.pieces(info.them, Pawn) & ~square_bb(capSq);
+    Square ksq = info.kingSq;
+
+    return !(attacks::pawn_attacks(info.us, ksq) & enemyPawns) &&
+           !(attacks::knight_attacks(ksq) & board.pieces(info.them, Knight)) &&
+           !(attacks::bishop_attacks(ksq, occ) &
+             (board.pieces(info.them, Bishop) | board.pieces(info.them, Queen))) &&
+           !(attacks::rook_attacks(ksq, occ) &
+             (board.pieces(info.them, Rook) | board.pieces(info.them, Queen)));
+}
+
+static void add_promotions(MoveList& moves, Square from, Square to) {
+    moves.add(make_promotion(from, to, Queen));
+    moves.add(make_promotion(from, to, Rook));
+    moves.add(make_promotion(from, to, Bishop));
+    moves.add(make_promotion(from, to, Knight));
+}
+
+// Captures and promotions (including quiet promotions) are "tactical"; everything else is
+// "quiet". Evasions and All emit both halves.
+static bool wants_tactical(GenType type) {
+    return type != GenType::Quiets;
+}
+
+static bool wants_quiets(GenType type) {
+    return type != GenType::Captures;
+}
+
+// `fromMask` restricts generation to pieces standing on those squares.
+static void generate_pawn_moves(const Board& board, const LegalityInfo& info, Bitboard fromMask,
+                                GenType type, MoveList& moves) {
+    Color us = info.us;
+    Color them = info.them;
     Bitboard enemy = board.pieces(them);
     Bitboard occ = board.all_pieces();
-    Bitboard pawns = board.pieces(us, Pawn);
+    Bitboard pawns = board.pieces(us, Pawn) & fromMask;
 
     int pushDir = (us == White) ? 8 : -8;
     Bitboard promoRank = (us == White) ? RankMask[7] : RankMask[0];
-    Bitboard startRank = (us == White) ? RankMask[1] : RankMask[6];
 
     // Single push
     Bitboard singlePush = (us == White) ? (pawns << 8) : (pawns >> 8);
     singlePush &= ~occ;
 
-    // Double push
+    // Double push (from the unmasked single pushes: the intermediate square need not block)
     Bitboard doublePush =
         (us == White) ? ((singlePush & RankMask[2]) << 8) : ((singlePush & RankMask[5]) >> 8);
-    doublePush &= ~occ;
+    doublePush &= ~occ & info.checkMask;
+    singlePush &= info.checkMask;
+    if (!wants_quiets(type)) {
+        singlePush &= promoRank;
+        doublePush = 0;
+    }
 
     // Non-promotion single pushes
     Bitboard pushNoPromo = singlePush & ~promoRank;
     while (pushNoPromo) {
         Square to = pop_lsb(pushNoPromo);
         Square from = Square(to - pushDir);
-        moves.add(make_move(from, to));
+        if (pin_allows(info, from, to))
+            moves.add(make_move(from, to));
     }
 
     // Promotion pushes
-    Bitboard pushPromo = singlePush & promoRank;
+    Bitboard pushPromo = wants_tactical(type) ? (singlePush & promoRank) : 0;
     while (pushPromo) {
         Square to = pop_lsb(pushPromo);
         Square from = Square(to - pushDir);
-        moves.add(make_promotion(from, to, Queen));
-        moves.add(make_promotion(from, to, Rook));
-        moves.add(make_promotion(from, to, Bishop));
-        moves.add(make_promotion(from, to, Knight));
+        if (pin_allows(info, from, to))
+            add_promotions(moves, from, to);
     }
 
     // Double pushes
     while (doublePush) {
         Square to = pop_lsb(doublePush);
         Square from = Square(to - 2 * pushDir);
-        moves.add(make_move(from, to));
+        if (pin_allows(info, from, to))
+            moves.add(make_move(from, to));
     }
 
+    if (!wants_tactical(type))
+        return;
+
     // Captures
-    Bitboard targets = enemy;
-    // Left captures
+    Bitboard targets = enemy & info.checkMask;
     Bitboard leftCap, rightCap;
     if (us == White) {
         leftCap = (pawns & ~FileMask[0]) << 7;
@@ -67,34 +195,32 @@ static void generate_pawn_moves(const Board& board, MoveList& moves) {
     while (leftCapNoPromo) {
         Square to = pop_lsb(leftCapNoPromo);
         Square from = (us == White) ? Square(to - 7) : Square(to + 7);
-        moves.add(make_move(from, to));
+        if (pin_allows(info, from, to))
+            moves.add(make_move(from, to));
     }
 
     Bitboard leftCapPromo = leftCap & targets & promoRank;
     while (leftCapPromo) {
         Square to = pop_lsb(leftCapPromo);
         Square from = (us == White) ? Square(to - 7) : Square(to + 7);
-        moves.add(make_promotion(from, to, Queen));
-        moves.add(make_promotion(from, to, Rook));
-        moves.add(make_promotion(from, to, Bishop));
-        moves.add(make_promotion(from, to, Knight));
+        if (pin_allows(info, from, to))
+            add_promotions(moves, from, to);
     }
 
     Bitboard rightCapNoPromo = rightCap & targets & ~promoRank;
     while (rightCapNoPromo) {
         Square to = pop_lsb(rightCapNoPromo);
         Square from = (us == White) ? Square(to - 9) : Square(to + 9);
-        moves.add(make_move(from, to));
+        if (pin_allows(info, from, to))
+            moves.add(make_move(from, to));
     }
 
     Bitboard rightCapPromo = rightCap & targets & promoRank;
     while (rightCapPromo) {
         Square to = pop_lsb(rightCapPromo);
         Square from = (us == White) ? Square(to - 9) : Square(to + 9);
-        moves.add(make_promotion(from, to, Queen));
-        moves.add(make_promotion(from, to, Rook));
-        moves.add(make_promotion(from, to, Bishop));
-        moves.add(make_promotion(from, to, Knight));
+        if (pin_allows(info, from, to))
+            add_promotions(moves, from, to);
     }
 
     // En passant
@@ -103,121 +229,165 @@ static void generate_pawn_moves(const Board& board, MoveList& moves) {
         Bitboard epAttackers = attacks::pawn_attacks(them, ep) & pawns;
         while (epAttackers) {
             Square from = pop_lsb(epAttackers);
-            moves.add(make_move(from, ep, EnPassant));
+            if (en_passant_is_legal(board, info, from, ep))
+                moves.add(make_move(from, ep, EnPassant));
         }
     }
 }
 
-static void generate_piece_moves(const Board& board, MoveList& moves) {
-    Color us = board.side_to_move();
-    Bitboard own = board.pieces(us);
+static void add_piece_moves(const LegalityInfo& info, Square from, Bitboard targets,
+                            MoveList& moves) {
+    if (info.pinned & square_bb(from))
+        targets &= attacks::line_bb(info.kingSq, from);
+    while (targets) {
+        Square to = pop_lsb(targets);
+        moves.add(make_move(from, to));
+    }
+}
+
+// Destination squares a non-pawn piece may move to for this generation type.
+static Bitboard piece_targets(const Board& board, const LegalityInfo& info, GenType type) {
+    if (type == GenType::Captures)
+        return board.pieces(info.them);
+    if (type == GenType::Quiets)
+        return ~board.all_pieces();
+    return ~board.pieces(info.us);
+}
+
+static void generate_piece_moves(const Board& board, const LegalityInfo& info, Bitboard fromMask,
+                                 GenType type, MoveList& moves) {
+    Color us = info.us;
     Bitboard occ = board.all_pieces();
+    Bitboard targetMask = piece_targets(board, info, type) & info.checkMask;
 
-    // Knights
-    Bitboard knights = board.pieces(us, Knight);
+    // Knights (a pinned knight can never move)
+    Bitboard knights = board.pieces(us, Knight) & ~info.pinned & fromMask;
     while (knights) {
         Square from = pop_lsb(knights);
-        Bitboard targets = attacks::knight_attacks(from) & ~own;
-        while (targets) {
-            Square to = pop_lsb(targets);
-            moves.add(make_move(from, to));
-        }
+        add_piece_moves(info, from, attacks::knight_attacks(from) & targetMask, moves);
     }
 
     // Bishops
-    Bitboard bishops = board.pieces(us, Bishop);
+    Bitboard bishops = board.pieces(us, Bishop) & fromMask;
     while (bishops) {
         Square from = pop_lsb(bishops);
-        Bitboard targets = attacks::bishop_attacks(from, occ) & ~own;
-        while (targets) {
-            Square to = pop_lsb(targets);
-            moves.add(make_move(from, to));
-        }
+        add_piece_moves(info, from, attacks::bishop_attacks(from, occ) & targetMask, moves);
     }
 
     // Rooks
-    Bitboard rooks = board.pieces(us, Rook);
+    Bitboard rooks = board.pieces(us, Rook) & fromMask;
     while (rooks) {
         Square from = pop_lsb(rooks);
-        Bitboard targets = attacks::rook_attacks(from, occ) & ~own;
-        while (targets) {
-            Square to = pop_lsb(targets);
-            moves.add(make_move(from, to));
-        }
+        add_piece_moves(info, from, attacks::rook_attacks(from, occ) & targetMask, moves);
     }
 
     // Queens
-    Bitboard queens = board.pieces(us, Queen);
+    Bitboard queens = board.pieces(us, Queen) & fromMask;
     while (queens) {
         Square from = pop_lsb(queens);
-        Bitboard targets = attacks::queen_attacks(from, occ) & ~own;
-        while (targets) {
-            Square to = pop_lsb(targets);
-            moves.add(make_move(from, to));
-        }
+        add_piece_moves(info, from, attacks::queen_attacks(from, occ) & targetMask, moves);
     }
+}
+
+static void generate_king_moves(const Board& board, const LegalityInfo& info, GenType type,
+                                MoveList& moves) {
+    Color us = info.us;
+    Bitboard occ = board.all_pieces();
+    Square kingSq = info.kingSq;
 
     // King (non-castling)
-    Square kingSq = lsb(board.pieces(us, King));
-    Bitboard kingTargets = attacks::king_attacks(kingSq) & ~own;
+    Bitboard kingTargets =
+        attacks::king_attacks(kingSq) & piece_targets(board, info, type) & ~info.danger;
     while (kingTargets) {
         Square to = pop_lsb(kingTargets);
         moves.add(make_move(kingSq, to));
     }
 
     // Castling
-    Color them = ~us;
+    if (info.checkers || !wants_quiets(type))
+        return;
     CastlingRights cr = board.castling_rights();
+    Bitboard danger = info.danger;
     if (us == White) {
         if ((cr & WhiteKingSide) && !(occ & (square_bb(F1) | square_bb(G1))) &&
-            !board.is_square_attacked(E1, them) && !board.is_square_attacked(F1, them) &&
-            !board.is_square_attacked(G1, them)) {
+            !(danger & (square_bb(F1) | square_bb(G1)))) {
             moves.add(make_move(E1, G1, Castling));
         }
         if ((cr & WhiteQueenSide) && !(occ & (square_bb(B1) | square_bb(C1) | square_bb(D1))) &&
-            !board.is_square_attacked(E1, them) && !board.is_square_attacked(D1, them) &&
-            !board.is_square_attacked(C1, them)) {
+            !(danger & (square_bb(C1) | square_bb(D1)))) {
             moves.add(make_move(E1, C1, Castling));
         }
     } else {
         if ((cr & BlackKingSide) && !(occ & (square_bb(F8) | square_bb(G8))) &&
-            !board.is_square_attacked(E8, them) && !board.is_square_attacked(F8, them) &&
-            !board.is_square_attacked(G8, them)) {
+            !(danger & (square_bb(F8) | square_bb(G8)))) {
             moves.add(make_move(E8, G8, Castling));
         }
         if ((cr & BlackQueenSide) && !(occ & (square_bb(B8) | square_bb(C8) | square_bb(D8))) &&
-            !board.is_square_attacked(E8, them) && !board.is_square_attacked(D8, them) &&
-            !board.is_square_attacked(C8, them)) {
+            !(danger & (square_bb(C8) | square_bb(D8)))) {
             moves.add(make_move(E8, C8, Castling));
         }
     }
 }
 
-MoveList generate_legal(Board& board) {
-    MoveList pseudo;
-    generate_pawn_moves(board, pseudo);
-    generate_piece_moves(board, pseudo);
-
-    Color us = board.side_to_move();
+MoveList generate_legal(const Board& board, GenType type) {
+    LegalityInfo info = compute_legality(board);
+    assert(type != GenType::Evasions || info.checkers);
     MoveList legal;
 
-    for (int i = 0; i < pseudo.size(); ++i) {
-        Board::UndoInfo undo;
-        board.make_move(pseudo[i], undo);
-        // After making the move, side has flipped, so check if our king is attacked by opponent
-        Square kingSq = lsb(board.pieces(us, King));
-        if (!board.is_square_attacked(kingSq, ~us)) {
-            legal.add(pseudo[i]);
-        }
-        board.unmake_move(pseudo[i], undo);
+    // In double check only the king can move.
+    if (!(info.checkers & (info.checkers - 1))) {
+        generate_pawn_moves(board, info, ~Bitboard(0), type, legal);
+        generate_piece_moves(board, info, ~Bitboard(0), type, legal);
     }
+    generate_king_moves(board, info, type, legal);
 
     return legal;
 }
 
-MoveList generate_legal(const Board& board) {
-    Board copy = board;
-    return generate_legal(copy);
+bool has_legal_moves(const Board& board) {
+    LegalityInfo info = compute_legality(board);
+
+    // Most positions have a safe king step, which settles it without generating anything.
+    if (attacks::king_attacks(info.kingSq) & ~board.pieces(info.us) & ~info.danger)
+        return true;
+    if (info.checkers & (info.checkers - 1))
+        return false;
+
+    MoveList moves;
+    generate_pawn_moves(board, info, ~Bitboard(0), GenType::All, moves);
+    if (moves.size() > 0)
+        return true;
+    generate_piece_moves(board, info, ~Bitboard(0), GenType::All, moves);
+    return moves.size() > 0;
+}
+
+bool is_legal(const Board& board, Move m) {
+    if (m == NullMove)
+        return false;
+
+    Square from = move_from(m);
+    Piece pc = board.piece_on(from);
+    if (pc == NoPiece || piece_color(pc) != board.side_to_move())
+        return false;
+
+    // Generate only the moving piece's moves; this keeps the check exact without
+    // duplicating the generator's rules.
+    LegalityInfo info = compute_legality(board);
+    MoveList moves;
+    if (piece_type(pc) == King) {
+        generate_king_moves(board, info, GenType::All, moves);
+    } else if (!(info.checkers & (info.checkers - 1))) {
+        if (piece_type(pc) == Pawn)
+            generate_pawn_moves(board, info, square_bb(from), GenType::All, moves);
+        else
+            generate_piece_moves(board, info, square_bb(from), GenType::All, moves);
+    }
+
+    for (Move legal : moves) {
+        if (legal == m)
+            return true;
+    }
+    return false;
 }
 
 bool in_check(const Board& board) {
@@ -229,13 +399,13 @@ bool in_check(const Board& board) {
 bool is_checkmate(const Board& board) {
     if (!in_check(board))
         return false;
-    return generate_legal(board).size() == 0;
+    return !has_legal_moves(board);
 }
 
 bool is_stalemate(const Board& board) {
     if (in_check(board))
         return false;
-    return generate_legal(board).size() == 0;
+    return !has_legal_moves(board);
 }
 
 bool is_draw_by_fifty_move_rule(const Board& board) {
@@ -243,8 +413,7 @@ bool is_draw_by_fifty_move_rule(const Board& board) {
 }
 
 GameTermination game_termination(const Board& board) {
-    MoveList legal = generate_legal(board);
-    if (legal.size() == 0) {
+    if (!has_legal_moves(board)) {
         return in_check(board) ? GameTermination::Checkmate : GameTermination::Stalemate;
     }
     if (is_draw_by_fifty_move_rule(board)) {
@@ -9,8 +9,25 @@ namespace panda {
 
 enum class GameTermination : uint8_t { None, Checkmate, Stalemate, FiftyMoveRule };
 
-MoveList generate_legal(const Board& board);
-MoveList generate_legal(Board& board);
+// Which slice of the legal moves to generate.
+//   Captures - captures, en passant and every promotion (quiet promotions included)
+//   Quiets   - everything else: non-promoting pushes, quiet piece moves and castling
+//   Evasions - all legal moves; only valid when the side to move is in check
+//   All      - all legal moves
+// Captures and Quiets partition All, in check or not.
+enum class GenType : uint8_t { Captures, Quiets, Evasions, All };
+
+// Generates strictly legal moves. Checkers, pinned pieces and king-danger squares are
+// computed once per call, so no make/unmake filtering is needed.
+MoveList generate_legal(const Board& board, GenType type = GenType::All);
+
+// True if the side to move has at least one legal move. Stops at the first one found,
+// so it is much cheaper than generating the full list.
+bool has_legal_moves(const Board& board);
+
+// True if `m` is a legal move in this position. Used to validate moves that did not come
+// from the generator (TT moves, killers) without generating the full list.
+bool is_legal(const Board& board, Move m);
 
 uint64_t perft(const Board& board, int depth);
 
@@ -1,15 +1,28 @@
 #include "nnue.h"
 
+#include <algorithm>
+#include <numeric>
+
+#include "bitboard.h"
+#include "board.h"
 #include "eval.h"
 #include "nnue/panda_nnue.h"
 
 namespace panda {
 
+// Context for evaluations outside a search. Building a context allocates an accumulator
+// stack and takes refresh caches from the pool, which costs more than the evaluation itself,
+// so each thread keeps one; its warm refresh caches also make the next reset cheaper.
+static nnue::SearchNnueContext& oneShotContext() {
+    thread_local nnue::SearchNnueContext ctx;
+    return ctx;
+}
+
 int evaluate_nnue(const Board& board) {
     if (!nnue::backend_loaded())
         return evaluate_handcrafted(board);
 
-    nnue::SearchNnueContext ctx;
+    nnue::SearchNnueContext& ctx = oneShotContext();
     if (!ctx.is_available())
         return evaluate_handcrafted(board);
 
@@ -27,6 +40,33 @@ int evaluate_nnue(const Board& board, nnue::SearchNnueContext* ctx) {
     return ctx->evaluate(board);
 }
 
+std::vector<int> evaluate_nnue_batch(const std::vector<Board>& boards) {
+    std::vector<int> scores(boards.size());
+    if (!nnue::backend_loaded()) {
+        for (std::size_t i = 0; i < boards.size(); ++i)
+            scores[i] = evaluate_handcrafted(boards[i]);
+        return scores;
+    }
+
+    // The accumulator refresh cache is indexed by king square, one entry per perspective.
+    // Visiting positions grouped by both king squares means each refresh only applies the
+    // difference from the last position with the same kings.
+    std::vector<std::size_t> order(boards.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    auto kingKey = [&boards](std::size_t i) {
+        return lsb(boards[i].pieces(White, King)) * 64 + lsb(boards[i].pieces(Black, King));
+    };
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return kingKey(a) < kingKey(b); });
+
+    nnue::SearchNnueContext& ctx = oneShotContext();
+    for (std::size_t i : order) {
+        ctx.reset(boards[i]);
+        scores[i] = ctx.evaluate(boards[i]);
+    }
+    return scores;
+}
+
 bool nnue_backend_ready() {
     return nnue::backend_loaded();
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 namespace panda {
 
 class Board;
@@ -12,6 +14,10 @@ class SearchNnueContext;
 int evaluate_nnue(const Board& board);
 int evaluate_nnue(const Board& board, nnue::SearchNnueContext* ctx);
 
+// Evaluates many positions with one reusable context, visiting them grouped by king squares
+// so accumulator refreshes reuse the cached accumulators. Scores come back in input order.
+std::vector<int> evaluate_nnue_batch(const std::vector<Board>& boards);
+
 // Returns true when SF18 NNUE backend and both nets are loaded.
 bool nnue_backend_ready();
 
@@ -0,0 +1,159 @@
+#include <algorithm>
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "board.h"
+#include "nnue/panda_nnue.h"
+
+namespace panda::nnue {
+
+namespace {
+
+class ThreatRecorder {
+   public:
+    explicit ThreatRecorder(DirtyThreats& threats) : threats(threats) {}
+
+    // Added threats also mark their squares, as Stockfish's Position does; the threat
+    // accumulator uses threateningSqs to fuse a move with a reply that captures an attacker.
+    void push(Piece attacker, Piece attacked, Square from, Square to, bool add) {
+        if (threats.list.size() == DirtyThreatList::MaxSize) {
+            overflowed = true;
+            return;
+        }
+        threats.list.push_back(DirtyThreat(attacker, attacked, from, to, add));
+        if (add) {
+            threats.threatenedSqs |= square_bb(to);
+            threats.threateningSqs |= square_bb(from);
+        }
+    }
+
+    bool ok() const {
+        return !overflowed;
+    }
+
+   private:
+    DirtyThreats& threats;
+    bool overflowed = false;
+};
+
+// True if `other` lies on the ray that starts at the slider and passes through `s`.
+bool on_same_ray(Square sliderSq, Square s, Square other) {
+    if (other == NoSquare || !(attacks::line_bb(sliderSq, s) & square_bb(other)))
+        return false;
+    return !(attacks::between_bb(other, s) & square_bb(sliderSq));
+}
+
+// Records the threats that change when `pc` appears on (Put) or leaves (!Put) square `s`.
+// `board` has `s` occupied by `pc` in both cases, so the same call serves a change made
+// forward or taken back. `other` is the far end of a two-step
+// piece move: a slider whose ray contains both ends keeps seeing the same piece behind
+// them, so the matching remove/add pair for that piece is skipped on both steps.
+template <bool Put>
+void record_piece_threats(const Board& board, Piece pc, Square s, Square other,
+                          ThreatRecorder& out) {
+    const Bitboard occupied = board.all_pieces();
+    const Bitboard rookAttacks = attacks::rook_attacks(s, occupied);
+    const Bitboard bishopAttacks = attacks::bishop_attacks(s, occupied);
+    const Bitboard queenAttacks = rookAttacks | bishopAttacks;
+
+    Bitboard threatened;
+    switch (piece_type(pc)) {
+        case Pawn:
+            threatened = attacks::pawn_attacks(piece_color(pc), s);
+            break;
+        case Knight:
+            threatened = attacks::knight_attacks(s);
+            break;
+        case Bishop:
+            threatened = bishopAttacks;
+            break;
+        case Rook:
+            threatened = rookAttacks;
+            break;
+        case Queen:
+            threatened = queenAttacks;
+            break;
+        default:
+            threatened = attacks::king_attacks(s);
+            break;
+    }
+    threatened &= occupied;
+    while (threatened) {
+        Square to = pop_lsb(threatened);
+        out.push(pc, board.piece_on(to), s, to, Put);
+    }
+
+    const Bitboard queens = board.pieces(White, Queen) | board.pieces(Black, Queen);
+    const Bitboard rookQueens = board.pieces(White, Rook) | board.pieces(Black, Rook) | queens;
+    const Bitboard bishopQueens =
+        board.pieces(White, Bishop) | board.pieces(Black, Bishop) | queens;
+
+    // Sliders that see `s` gain or lose the piece behind it on the same line.
+    Bitboard sliders = (rookQueens & rookAttacks) | (bishopQueens & bishopAttacks);
+    while (sliders) {
+        Square sliderSq = pop_lsb(sliders);
+        Piece slider = board.piece_on(sliderSq);
+
+        Bitboard behind =
+            attacks::line_bb(sliderSq, s) & queenAttacks & occupied & ~square_bb(sliderSq);
+        if (behind && !on_same_ray(sliderSq, s, other)) {
+            Square to = lsb(behind);
+            out.push(slider, board.piece_on(to), sliderSq, to, !Put);
+        }
+        out.push(slider, pc, sliderSq, s, Put);
+    }
+
+    Bitboard incoming =
+        (attacks::knight_attacks(s) & (board.pieces(White, Knight) | board.pieces(Black, Knight))) |
+        (attacks::king_attacks(s) & (board.pieces(White, King) | board.pieces(Black, King))) |
+        (attacks::pawn_attacks(Black, s) & board.pieces(White, Pawn)) |
+        (attacks::pawn_attacks(White, s) & board.pieces(Black, Pawn));
+    while (incoming) {
+        Square from = pop_lsb(incoming);
+        out.push(board.piece_on(from), pc, from, s, Put);
+    }
+}
+
+}  // namespace
+
+bool unwind_move_threats(Board& board, const DirtyPiece& dp, DirtyThreats& dirtyThreats) {
+    // Take the move back one piece change at a time, so each change sees the occupancy it
+    // happened in. Every step records the threats of the forward change, which differ from
+    // the backward one only in sign.
+    ThreatRecorder out(dirtyThreats);
+    const std::size_t first = dirtyThreats.list.size();
+
+    if (dp.add_sq != NoSquare) {
+        record_piece_threats<true>(board, dp.add_pc, dp.add_sq, NoSquare, out);
+        board.remove_piece(dp.add_sq);
+    }
+
+    if (dp.to != NoSquare) {
+        record_piece_threats<true>(board, dp.pc, dp.to, dp.from, out);
+        board.remove_piece(dp.to);
+        board.put_piece(dp.pc, dp.from);
+        record_piece_threats<false>(board, dp.pc, dp.from, dp.to, out);
+    } else {
+        // Promotion: the new piece was removed above as add_pc
+        board.put_piece(dp.pc, dp.from);
+        record_piece_threats<false>(board, dp.pc, dp.from, NoSquare, out);
+    }
+
+    if (dp.remove_sq != NoSquare) {
+        board.put_piece(dp.remove_pc, dp.remove_sq);
+        record_piece_threats<false>(board, dp.remove_pc, dp.remove_sq, NoSquare, out);
+    }
+
+    // Hand the changes over in the order the move made them. The accumulator's fused update
+    // drops an added threat against a later removal of the same pair; a capture that removed
+    // a threat before adding it back must not have the removal dropped as well.
+    std::reverse(dirtyThreats.list.begin() + first, dirtyThreats.list.end());
+    return out.ok();
+}
+
+bool append_move_threats(const Board& board, const DirtyPiece& dp, DirtyThreats& dirtyThreats) {
+    Board scratch = board;
+    return unwind_move_threats(scratch, dp, dirtyThreats);
+}
+
+}  // namespace panda::nnue
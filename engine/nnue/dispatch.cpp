@@ -0,0 +1,168 @@
+#include <iterator>
+
+#include "nnue/kernel.h"
+#include "nnue/panda_nnue.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define PANDA_X86_CPU_DETECT
+#endif
+
+namespace panda::nnue {
+
+namespace {
+
+// Feature checks for each kernel set. __builtin_cpu_supports also verifies that the OS saves
+// the wide registers, so an AVX-512 CPU under an OS without AVX-512 support is not picked.
+#ifdef PANDA_X86_CPU_DETECT
+[[maybe_unused]] bool has_sse41() {
+    return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt");
+}
+
+[[maybe_unused]] bool has_avx2() {
+    return has_sse41() && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi");
+}
+
+[[maybe_unused]] bool has_avxvnni() {
+    // CPUID.(EAX=7,ECX=1):EAX bit 4; not every compiler knows "avxvnni" as a feature name
+    unsigned eax, ebx, ecx, edx;
+    return has_avx2() && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx) && (eax & (1u << 4));
+}
+
+[[maybe_unused]] bool has_avx512() {
+    return has_avx2() && __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") &&
+           __builtin_cpu_supports("avx512vl");
+}
+
+[[maybe_unused]] bool has_vnni512() {
+    return has_avx512() && __builtin_cpu_supports("avx512vnni");
+}
+#else
+// No runtime detection on this compiler: only the baseline set is ever chosen.
+[[maybe_unused]] bool has_sse41() {
+    return false;
+}
+[[maybe_unused]] bool has_avx2() {
+    return false;
+}
+[[maybe_unused]] bool has_avxvnni() {
+    return false;
+}
+[[maybe_unused]] bool has_avx512() {
+    return false;
+}
+[[maybe_unused]] bool has_vnni512() {
+    return false;
+}
+#endif
+
+bool always() {
+    return true;
+}
+
+struct Candidate {
+    const Kernel* kernel;
+    bool (*supported)();
+};
+
+// Best first; only the sets CMake built are listed.
+const Candidate Candidates[] = {
+#ifdef PANDA_NNUE_HAS_VNNI512
+    {&kernel_vnni512, has_vnni512},
+#endif
+#ifdef PANDA_NNUE_HAS_AVX512
+    {&kernel_avx512, has_avx512},
+#endif
+#ifdef PANDA_NNUE_HAS_AVXVNNI
+    {&kernel_avxvnni, has_avxvnni},
+#endif
+#ifdef PANDA_NNUE_HAS_AVX2
+    {&kernel_avx2, has_avx2},
+#endif
+#ifdef PANDA_NNUE_HAS_SSE41
+    {&kernel_sse41, has_sse41},
+#endif
+#ifdef PANDA_NNUE_HAS_SSE2
+    {&kernel_sse2, always},
+#endif
+#ifdef PANDA_NNUE_HAS_NEON
+    {&kernel_neon, always},
+#endif
+#ifdef PANDA_NNUE_HAS_GENERIC
+    {&kernel_generic, always},
+#endif
+};
+
+const Kernel& select_kernel() {
+    static const Kernel& selected = []() -> const Kernel& {
+        for (const Candidate& c : Candidates) {
+            if (c.supported())
+                return *c.kernel;
+        }
+        // A single-set build for a CPU we cannot check: trust the build configuration.
+        return *Candidates[std::size(Candidates) - 1].kernel;
+    }();
+    return selected;
+}
+
+}  // namespace
+
+SearchNnueContext::SearchNnueContext() : impl(select_kernel().make_context()) {}
+
+SearchNnueContext::~SearchNnueContext() = default;
+
+SearchNnueContext::SearchNnueContext(SearchNnueContext&&) noexcept = default;
+
+SearchNnueContext& SearchNnueContext::operator=(SearchNnueContext&&) noexcept = default;
+
+void SearchNnueContext::reset(const Board& board) {
+    impl->reset(board);
+}
+
+void SearchNnueContext::on_make_move(const Board& board, Move, const DirtyPiece& dirtyPiece,
+                                     const DirtyThreats& dirtyThreats) {
+    impl->on_make_move(board, dirtyPiece, dirtyThreats);
+}
+
+void SearchNnueContext::on_unmake_move(const Board& board) {
+    impl->on_unmake_move(board);
+}
+
+void SearchNnueContext::on_null_move(const Board& board) {
+    impl->on_null_move(board);
+}
+
+void SearchNnueContext::on_unmake_null_move(const Board& board) {
+    impl->on_unmake_null_move(board);
+}
+
+int SearchNnueContext::evaluate(const Board& board) {
+    return impl->evaluate(board);
+}
+
+bool SearchNnueContext::is_available() const {
+    return impl->available();
+}
+
+bool SearchNnueContext::is_loaded() const {
+    return backend_loaded();
+}
+
+UpdateCounts SearchNnueContext::update_counts() const {
+    return impl->update_counts();
+}
+
+bool backend_loaded() {
+    return select_kernel().loaded();
+}
+
+void preallocate_contexts(int threadCount) {
+    select_kernel().preallocate(threadCount);
+}
+
+const char* kernel_name() {
+    return select_kernel().name;
+}
+
+}  // namespace panda::nnue
@@ -25,10 +25,10 @@
 #include <initializer_list>
 #include <utility>
 
-#include "../../bitboard.h"
-#include "../../misc.h"
-#include "../../position.h"
-#include "../../types.h"
+#include "stockfish_src/bitboard.h"
+#include "stockfish_src/misc.h"
+#include "nnue/nnue_position.h"
+#include "stockfish_src/types.h"
 #include "../nnue_common.h"
 
 namespace Stockfish::Eval::NNUE::Features {
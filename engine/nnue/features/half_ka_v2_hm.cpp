@@ -20,9 +20,9 @@
 
 #include "half_ka_v2_hm.h"
 
-#include "../../bitboard.h"
-#include "../../position.h"
-#include "../../types.h"
+#include "stockfish_src/bitboard.h"
+#include "nnue/nnue_position.h"
+#include "stockfish_src/types.h"
 #include "../nnue_common.h"
 
 namespace Stockfish::Eval::NNUE::Features {
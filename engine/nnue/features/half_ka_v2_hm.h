@@ -23,12 +23,12 @@
 
 #include <cstdint>
 
-#include "../../misc.h"
-#include "../../types.h"
+#include "stockfish_src/misc.h"
+#include "stockfish_src/types.h"
 #include "../nnue_common.h"
 
-namespace Stockfish {
-class Position;
+namespace Stockfish::Eval::NNUE {
+class Position;  // panda::Board view, see nnue/nnue_position.h
 }
 
 namespace Stockfish::Eval::NNUE::Features {
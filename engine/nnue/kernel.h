@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+
+#include "nnue/panda_nnue.h"
+
+namespace panda::nnue {
+
+// Per-search accumulator state of one NNUE kernel set; SearchNnueContext forwards to it.
+class KernelContext {
+   public:
+    virtual ~KernelContext() = default;
+
+    virtual bool available() const = 0;
+    virtual void reset(const Board& board) = 0;
+    virtual void on_make_move(const Board& board, const DirtyPiece& dirtyPiece,
+                              const DirtyThreats& dirtyThreats) = 0;
+    virtual void on_unmake_move(const Board& board) = 0;
+    virtual void on_null_move(const Board& board) = 0;
+    virtual void on_unmake_null_move(const Board& board) = 0;
+    virtual int evaluate(const Board& board) = 0;
+    virtual UpdateCounts update_counts() const = 0;
+};
+
+// One build of the NNUE backend (nnue/panda_nnue.cpp and the Stockfish core) for a given
+// instruction set. CMake compiles the backend once per kernel set, which defines
+// kernel_<set>, and nnue/dispatch.cpp picks the best one the CPU supports.
+struct Kernel {
+    const char* name;
+    bool (*loaded)();  // loads the nets on first call
+    std::unique_ptr<KernelContext> (*make_context)();
+    void (*preallocate)(int contexts);  // loads the nets and pools per-context caches
+};
+
+extern const Kernel kernel_generic;
+extern const Kernel kernel_neon;
+extern const Kernel kernel_sse2;
+extern const Kernel kernel_sse41;
+extern const Kernel kernel_avx2;
+extern const Kernel kernel_avxvnni;
+extern const Kernel kernel_avx512;
+extern const Kernel kernel_vnni512;
+
+}  // namespace panda::nnue
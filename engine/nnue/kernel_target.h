@@ -0,0 +1,60 @@
+#pragma once
+
+// Force-included ahead of every source of an NNUE kernel set built with GCC (see
+// CMakeLists.txt). The headers a kernel set shares with the rest of the engine, the standard
+// library and the engine's own, are read here under the baseline target, so their inline
+// functions and template instantiations come out the same in every object and the linker may
+// keep any copy. Everything after this header, the Stockfish core and the kernel set's own
+// code, is compiled for PANDA_NNUE_TARGET; those symbols live in the Stockfish_<set> and
+// kernel_<set> namespaces and are only reached once dispatch.cpp has checked the CPU.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iomanip>
+#include <iosfwd>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bitboard.h"
+#include "board.h"
+#include "move.h"
+#include "nnue/kernel.h"
+#include "nnue/panda_nnue.h"
+#include "nnue/weight_blob.h"
+#include "search_stats.h"
+#include "types.h"
+
+#ifdef PANDA_NNUE_TARGET
+#define PANDA_NNUE_PRAGMA_(x) _Pragma(#x)
+#define PANDA_NNUE_PRAGMA(x) PANDA_NNUE_PRAGMA_(x)
+PANDA_NNUE_PRAGMA(GCC target(PANDA_NNUE_TARGET))
+#endif
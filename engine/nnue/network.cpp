@@ -26,12 +26,12 @@
 #include <vector>
 
 #define INCBIN_SILENCE_BITCODE_WARNING
-#include "../incbin/incbin.h"
+#include "stockfish_src/incbin/incbin.h"
 
-#include "../evaluate.h"
-#include "../misc.h"
-#include "../position.h"
-#include "../types.h"
+#include "stockfish_src/evaluate.h"
+#include "stockfish_src/misc.h"
+#include "nnue/nnue_position.h"
+#include "stockfish_src/types.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
 #include "nnue_misc.h"
@@ -108,7 +108,7 @@ bool write_parameters(std::ostream& stream, const T& reference) {
 }  // namespace Detail
 
 template<typename Arch, typename Transformer>
-void Network<Arch, Transformer>::load(const std::string& rootDirectory, std::string evalfilePath) {
+bool Network<Arch, Transformer>::load(const std::string& rootDirectory, std::string evalfilePath) {
 #if defined(DEFAULT_NNUE_DIRECTORY)
     std::vector<std::string> dirs = {"<internal>", "", rootDirectory,
                                      stringify(DEFAULT_NNUE_DIRECTORY)};
@@ -134,6 +134,8 @@ void Network<Arch, Transformer>::load(const std::string& rootDirectory, std::str
             }
         }
     }
+
+    return std::string(evalFile.current) == evalfilePath;
 }
 
 
@@ -29,8 +29,8 @@
 #include <string_view>
 #include <tuple>
 
-#include "../misc.h"
-#include "../types.h"
+#include "stockfish_src/misc.h"
+#include "stockfish_src/types.h"
 #include "nnue_accumulator.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
@@ -68,7 +68,8 @@ class Network {
     Network& operator=(const Network& other) = default;
     Network& operator=(Network&& other)      = default;
 
-    void load(const std::string& rootDirectory, std::string evalfilePath);
+    // Returns true if evalfilePath ends up loaded
+    bool load(const std::string& rootDirectory, std::string evalfilePath);
     bool save(const std::optional<std::string>& filename) const;
 
     std::size_t get_content_hash() const;
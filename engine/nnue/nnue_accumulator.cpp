@@ -23,10 +23,10 @@
 #include <new>
 #include <type_traits>
 
-#include "../bitboard.h"
-#include "../misc.h"
-#include "../position.h"
-#include "../types.h"
+#include "stockfish_src/bitboard.h"
+#include "stockfish_src/misc.h"
+#include "nnue/nnue_position.h"
+#include "stockfish_src/types.h"
 #include "features/half_ka_v2_hm.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
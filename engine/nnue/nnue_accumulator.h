@@ -27,12 +27,12 @@
 #include <cstring>
 #include <utility>
 
-#include "../types.h"
+#include "stockfish_src/types.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
 
-namespace Stockfish {
-class Position;
+namespace Stockfish::Eval::NNUE {
+class Position;  // panda::Board view, see nnue/nnue_position.h
 }
 
 namespace Stockfish::Eval::NNUE {
@@ -27,8 +27,8 @@
 #include <iosfwd>
 #include <iterator>
 
-#include "../position.h"
-#include "../types.h"
+#include "nnue/nnue_position.h"
+#include "stockfish_src/types.h"
 #include "nnue_accumulator.h"
 #include "nnue_architecture.h"
 #include "nnue_common.h"
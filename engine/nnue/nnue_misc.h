@@ -23,16 +23,17 @@
 #include <memory>
 #include <string>
 
-#include "../misc.h"
-#include "../types.h"
+#include "stockfish_src/misc.h"
+#include "stockfish_src/types.h"
 #include "nnue_architecture.h"
 
 namespace Stockfish {
 
-class Position;
-
 namespace Eval::NNUE {
 
+class Position;  // panda::Board view, see nnue/nnue_position.h
+
+
 // EvalFile uses fixed string types because it's part of the network structure which must be trivial.
 struct EvalFile {
     // Default net name, will use one of the EvalFileDefaultName* macros defined
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+
+#include "board.h"
+#include "stockfish_src/bitboard.h"
+#include "stockfish_src/types.h"
+
+namespace Stockfish::Eval::NNUE {
+
+// Read-only view of a panda::Board in Stockfish encodings. It answers exactly the queries
+// the NNUE feature sets, accumulators and networks make, so they evaluate the search board
+// itself instead of a shadow Stockfish Position. Squares and colors share the same numbering
+// in both engines; pieces and piece types are translated.
+class Position {
+   public:
+    explicit Position(const panda::Board& board) : board(board) {}
+
+    Color side_to_move() const {
+        return Color(board.side_to_move());
+    }
+
+    Piece piece_on(Square s) const {
+        return to_sf_piece(board.piece_on(panda::Square(s)));
+    }
+
+    Bitboard pieces() const {
+        return board.all_pieces();
+    }
+
+    Bitboard pieces(Color c, PieceType pt) const {
+        return board.pieces(panda::Color(c), panda::PieceType(pt - PAWN));
+    }
+
+    template <PieceType Pt>
+    Square square(Color c) const {
+        static_assert(Pt == KING, "only the king square is tracked");
+        return Square(panda::lsb(board.pieces(panda::Color(c), panda::King)));
+    }
+
+    template <PieceType Pt>
+    int count() const {
+        static_assert(Pt == ALL_PIECES, "only the total piece count is needed");
+        return panda::popcount(board.all_pieces());
+    }
+
+    // Built on first use: only accumulator cache refreshes read the whole board.
+    const std::array<Piece, SQUARE_NB>& piece_array() const {
+        if (!pieceArrayBuilt) {
+            for (int s = 0; s < SQUARE_NB; ++s) pieceArray[s] = piece_on(Square(s));
+            pieceArrayBuilt = true;
+        }
+        return pieceArray;
+    }
+
+    static Piece to_sf_piece(panda::Piece p) {
+        constexpr Piece Pieces[panda::PieceCount] = {W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK,
+                                                     W_QUEEN, W_KING, B_PAWN, B_KNIGHT,
+                                                     B_BISHOP, B_ROOK, B_QUEEN, B_KING};
+        return p == panda::NoPiece ? NO_PIECE : Pieces[p];
+    }
+
+   private:
+    const panda::Board& board;
+    mutable std::array<Piece, SQUARE_NB> pieceArray;
+    mutable bool pieceArrayBuilt = false;
+};
+
+}  // namespace Stockfish::Eval::NNUE
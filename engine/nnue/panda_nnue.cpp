@@ -3,23 +3,42 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "board.h"
+#include "nnue/kernel.h"
+#include "nnue/network.h"
+#include "nnue/nnue_accumulator.h"
+#include "nnue/nnue_position.h"
+#include "nnue/weight_blob.h"
+#include "search_stats.h"
 #include "stockfish_src/bitboard.h"
-#include "stockfish_src/nnue/network.h"
-#include "stockfish_src/nnue/nnue_accumulator.h"
-#include "stockfish_src/position.h"
 #include "stockfish_src/types.h"
 
+#ifndef PANDA_NNUE_KERNEL
+#error "PANDA_NNUE_KERNEL must name the kernel set this backend is built for"
+#endif
+
+#define PANDA_NNUE_STR_(x) #x
+#define PANDA_NNUE_STR(x) PANDA_NNUE_STR_(x)
+#define PANDA_NNUE_CAT_(a, b) a##b
+#define PANDA_NNUE_CAT(a, b) PANDA_NNUE_CAT_(a, b)
+
+// Compiled for this kernel set's instruction set, so kept apart from the other sets' copies
+#define PANDA_NNUE_IMPL PANDA_NNUE_CAT(PANDA_NNUE_CAT(kernel_, PANDA_NNUE_KERNEL), _impl)
+
 namespace panda::nnue {
 
+namespace PANDA_NNUE_IMPL {
 namespace {
 
 namespace sf = Stockfish;
@@ -53,33 +72,12 @@ sf::Eval::NNUE::EvalFile make_eval_file(const std::string& defaultName) {
     return file;
 }
 
-sf::PieceType to_sf_piece_type(PieceType pt) {
-    switch (pt) {
-        case Pawn:
-            return sf::PAWN;
-        case Knight:
-            return sf::KNIGHT;
-        case Bishop:
-            return sf::BISHOP;
-        case Rook:
-            return sf::ROOK;
-        case Queen:
-            return sf::QUEEN;
-        case King:
-            return sf::KING;
-        default:
-            return sf::NO_PIECE_TYPE;
-    }
-}
-
 sf::Color to_sf_color(Color c) {
     return c == White ? sf::WHITE : sf::BLACK;
 }
 
 sf::Piece to_sf_piece(Piece p) {
-    if (p == NoPiece)
-        return sf::NO_PIECE;
-    return sf::make_piece(to_sf_color(piece_color(p)), to_sf_piece_type(piece_type(p)));
+    return sf::Eval::NNUE::Position::to_sf_piece(p);
 }
 
 sf::Square to_sf_square(Square s) {
@@ -100,50 +98,19 @@ sf::DirtyPiece to_sf_dirty_piece(const DirtyPiece& dirty) {
     return out;
 }
 
-bool has_nonempty_threat_delta(const DirtyThreats& dirtyThreats) {
-    return dirtyThreats.list.size() != 0 || dirtyThreats.threatenedSqs != 0 ||
-           dirtyThreats.threateningSqs != 0;
-}
-
-sf::DirtyThreats to_sf_dirty_threats(const DirtyThreats& dirtyThreats) {
-    sf::DirtyThreats out{};
+void to_sf_dirty_threats(const DirtyThreats& dirtyThreats, sf::DirtyThreats& out) {
     out.us = to_sf_color(dirtyThreats.us);
     out.prevKsq = to_sf_square(dirtyThreats.prevKsq);
     out.ksq = to_sf_square(dirtyThreats.ksq);
-    out.threatenedSqs = sf::Bitboard(dirtyThreats.threatenedSqs);
-    out.threateningSqs = sf::Bitboard(dirtyThreats.threateningSqs);
+    out.threatenedSqs = dirtyThreats.threatenedSqs;
+    out.threateningSqs = dirtyThreats.threateningSqs;
 
     for (const DirtyThreat& dirty : dirtyThreats.list) {
-        out.list.push_back(sf::DirtyThreat(to_sf_piece(dirty.pc()), to_sf_piece(dirty.threatened_pc()),
+        out.list.push_back(sf::DirtyThreat(to_sf_piece(dirty.pc()),
+                                           to_sf_piece(dirty.threatened_pc()),
                                            to_sf_square(dirty.pc_sq()),
                                            to_sf_square(dirty.threatened_sq()), dirty.add()));
     }
-    return out;
-}
-
-sf::Move to_sf_move(const Board& board, Move m) {
-    const Square from = move_from(m);
-    const Square to = move_to(m);
-    const MoveType mt = move_type(m);
-
-    const sf::Square sfFrom = to_sf_square(from);
-    const sf::Square sfTo = to_sf_square(to);
-
-    if (mt == Castling) {
-        const bool kingSide = to > from;
-        const Square rookFrom = make_square(kingSide ? 7 : 0, square_rank(from));
-        return sf::Move::make<sf::CASTLING>(sfFrom, to_sf_square(rookFrom));
-    }
-
-    if (mt == EnPassant)
-        return sf::Move::make<sf::EN_PASSANT>(sfFrom, sfTo);
-
-    if (mt == Promotion) {
-        const sf::PieceType promo = to_sf_piece_type(promotion_type(m));
-        return sf::Move::make<sf::PROMOTION>(sfFrom, sfTo, promo);
-    }
-
-    return sf::Move(sfFrom, sfTo);
 }
 
 struct Backend {
@@ -152,7 +119,12 @@ struct Backend {
     bool initTried = false;
     std::string bigPath;
     std::string smallPath;
-    std::unique_ptr<sf::Eval::NNUE::Networks> networks;
+    std::unique_ptr<sf::Eval::NNUE::Networks> ownedNetworks;  // parsed from the .nnue files
+    WeightBlob blob;                                          // or mapped from a weight blob
+    const sf::Eval::NNUE::Networks* networks = nullptr;
+
+    std::mutex cachePoolMutex;
+    std::vector<std::unique_ptr<sf::Eval::NNUE::AccumulatorCaches>> freeCaches;
 };
 
 Backend& backend() {
@@ -160,12 +132,40 @@ Backend& backend() {
     return b;
 }
 
+// Networks hold their weights inline, so a loaded copy can be written out and mapped back.
+static_assert(std::is_trivially_copyable_v<sf::Eval::NNUE::Networks>);
+
+WeightBlobHeader expected_blob_header(const Backend& b) {
+    WeightBlobHeader header;
+    std::strncpy(header.kernel, PANDA_NNUE_STR(PANDA_NNUE_KERNEL), sizeof(header.kernel) - 1);
+    header.payloadSize = sizeof(sf::Eval::NNUE::Networks);
+    header.bigNetHash = b.bigPath.empty() ? 0 : file_content_hash(b.bigPath);
+    header.smallNetHash = b.smallPath.empty() ? 0 : file_content_hash(b.smallPath);
+    return header;
+}
+
 void init_backend_once() {
     Backend& b = backend();
     b.initTried = true;
 
     b.bigPath = resolve_net_path(kBigNetName);
     b.smallPath = resolve_net_path(kSmallNetName);
+    sf::Bitboards::init();
+
+    // PANDA_NNUE_BLOB names a weight blob shared by every engine process on the host. The
+    // first process to start without one parses the nets and writes it for the others.
+    const char* blobEnv = std::getenv("PANDA_NNUE_BLOB");
+    const std::string blobPath = blobEnv ? blobEnv : "";
+    WeightBlobHeader blobHeader;
+    if (!blobPath.empty()) {
+        blobHeader = expected_blob_header(b);
+        b.blob = WeightBlob::map(blobPath, blobHeader);
+        if (b.blob) {
+            b.networks = static_cast<const sf::Eval::NNUE::Networks*>(b.blob.payload());
+            b.loaded = true;
+            return;
+        }
+    }
 
     if (b.bigPath.empty() || b.smallPath.empty()) {
         std::cerr << "NNUE: missing SF18 nets (" << kBigNetName << ", " << kSmallNetName
@@ -174,22 +174,24 @@ void init_backend_once() {
         return;
     }
 
-    sf::Bitboards::init();
-    sf::Position::init();
-
     auto bigFile = make_eval_file(b.bigPath);
     auto smallFile = make_eval_file(b.smallPath);
-    b.networks = std::make_unique<sf::Eval::NNUE::Networks>(bigFile, smallFile);
+    b.ownedNetworks = std::make_unique<sf::Eval::NNUE::Networks>(bigFile, smallFile);
 
-    const bool bigLoaded = b.networks->big.load("", b.bigPath);
-    const bool smallLoaded = b.networks->small.load("", b.smallPath);
+    const bool bigLoaded = b.ownedNetworks->big.load("", b.bigPath);
+    const bool smallLoaded = b.ownedNetworks->small.load("", b.smallPath);
     b.loaded = bigLoaded && smallLoaded;
 
     if (!b.loaded) {
         std::cerr << "NNUE: failed to load SF18 nets from " << b.bigPath << " / " << b.smallPath
                   << ", falling back to handcrafted eval" << std::endl;
-        b.networks.reset();
+        b.ownedNetworks.reset();
+        return;
     }
+    b.networks = b.ownedNetworks.get();
+
+    if (!blobPath.empty() && !WeightBlob::write(blobPath, blobHeader, b.ownedNetworks.get()))
+        std::cerr << "NNUE: could not write weight blob " << blobPath << std::endl;
 }
 
 bool ensure_backend() {
@@ -198,85 +200,122 @@ bool ensure_backend() {
     return b.loaded;
 }
 
-class SfContext {
+// Accumulator caches are large and are built from the network biases, so search contexts
+// take them from a pool and give them back rather than building their own every search.
+using CachesPtr = std::unique_ptr<sf::Eval::NNUE::AccumulatorCaches>;
+
+CachesPtr acquire_caches() {
+    Backend& b = backend();
+    {
+        std::lock_guard<std::mutex> lock(b.cachePoolMutex);
+        if (!b.freeCaches.empty()) {
+            CachesPtr caches = std::move(b.freeCaches.back());
+            b.freeCaches.pop_back();
+            return caches;
+        }
+    }
+    return std::make_unique<sf::Eval::NNUE::AccumulatorCaches>(*b.networks);
+}
+
+void release_caches(CachesPtr caches) {
+    Backend& b = backend();
+    std::lock_guard<std::mutex> lock(b.cachePoolMutex);
+    b.freeCaches.push_back(std::move(caches));
+}
+
+// Loads the nets if needed and leaves `count` caches in the pool. Caches held by a running
+// search are not counted; they rejoin the pool when it ends.
+void preallocate(int count) {
+    if (!ensure_backend())
+        return;
+
+    Backend& b = backend();
+    std::lock_guard<std::mutex> lock(b.cachePoolMutex);
+    const std::size_t wanted = std::size_t(std::max(count, 0));
+    if (b.freeCaches.size() > wanted)
+        b.freeCaches.resize(wanted);
+    while (b.freeCaches.size() < wanted)
+        b.freeCaches.push_back(std::make_unique<sf::Eval::NNUE::AccumulatorCaches>(*b.networks));
+}
+
+// Accumulator stack driven directly by the search board. Making a move only records the
+// dirty piece from Board::make_move; the moves are pushed onto the accumulator stack, with
+// their threat changes, when an evaluation actually needs them. Subtrees that end in a TT
+// cutoff, a draw or an eval cache hit before any evaluation never pay for the update; in
+// bench that is about 40% of the moves made.
+class BoardContext final : public KernelContext {
    public:
-    SfContext() = default;
+    BoardContext() = default;
+
+    ~BoardContext() override {
+        if (caches)
+            release_caches(std::move(caches));
+    }
 
-    bool available() const {
+    bool available() const override {
         return ensure_backend();
     }
 
-    void reset(const Board& board) {
+    void reset(const Board& board) override {
         if (!ensure_backend())
             return;
 
         if (!caches)
-            caches = std::make_unique<sf::Eval::NNUE::AccumulatorCaches>(*backend().networks);
+            caches = acquire_caches();
 
-        const std::string fen = board.to_fen();
-        states.resize(MaxPly + 8);
-        pos.set(fen, false, &states[0]);
         accumulators.reset();
-        moves.clear();
+        if constexpr (SEARCH_STATS_ENABLED)
+            ++counts.refreshes;
+        plies = 0;
+        materialized = 0;
         synced = true;
         syncedHash = board.hash_key();
     }
 
-    void on_make_move(const Board& board, Move m, const DirtyPiece& dirtyPiece,
-                      const DirtyThreats& dirtyThreats) {
+    void on_make_move(const Board& board, const DirtyPiece& dirtyPiece,
+                      const DirtyThreats& dirtyThreats) override {
         if (!ensure_backend())
             return;
 
-        if (!synced) {
+        if (!synced || plies + 1 >= MaxPlies) {
             reset(board);
             return;
         }
 
-        if (moves.size() + 1 >= states.size()) {
-            synced = false;
-            reset(board);
-            return;
-        }
-
-        const sf::Move sfMove = to_sf_move(board, m);
-        auto [sfDirtyPiece, sfDirtyThreats] = accumulators.push();
-        const bool givesCheck = pos.gives_check(sfMove);
-        pos.do_move(sfMove, states[moves.size() + 1], givesCheck, sfDirtyPiece, sfDirtyThreats,
-                    nullptr, nullptr);
-
-        sfDirtyPiece = to_sf_dirty_piece(dirtyPiece);
-        if (has_nonempty_threat_delta(dirtyThreats))
-            sfDirtyThreats = to_sf_dirty_threats(dirtyThreats);
-
-        moves.push_back(sfMove);
+        pending[plies++] = {dirtyPiece, dirtyThreats.us, dirtyThreats.prevKsq, dirtyThreats.ksq};
         syncedHash = board.hash_key();
     }
 
-    void on_unmake_move(const Board& board) {
+    void on_unmake_move(const Board& board) override {
         if (!ensure_backend())
             return;
 
-        if (!synced || moves.empty()) {
+        if (!synced || plies == 0) {
             reset(board);
             return;
         }
 
-        const sf::Move sfMove = moves.back();
-        moves.pop_back();
-        pos.undo_move(sfMove);
-        accumulators.pop();
+        --plies;
+        if (materialized > plies) {
+            accumulators.pop();
+            materialized = plies;
+        }
         syncedHash = board.hash_key();
     }
 
-    void on_null_move(const Board&) {
-        synced = false;
+    // A null move changes no piece, so the child shares the parent's accumulators; only the
+    // side to move flips, which the network reads from the board when it evaluates.
+    void on_null_move(const Board& board) override {
+        if (synced)
+            syncedHash = board.hash_key();
     }
 
-    void on_unmake_null_move(const Board&) {
-        synced = false;
+    void on_unmake_null_move(const Board& board) override {
+        if (synced)
+            syncedHash = board.hash_key();
     }
 
-    int evaluate(const Board& board) {
+    int evaluate(const Board& board) override {
         if (!ensure_backend())
             return 0;
 
@@ -286,9 +325,13 @@ class SfContext {
         if (!synced)
             return 0;
 
-        const sf::Color stm = pos.side_to_move();
-        const int simpleEval = sf::PawnValue * (pos.count<sf::PAWN>(stm) - pos.count<sf::PAWN>(~stm))
-                             + pos.non_pawn_material(stm) - pos.non_pawn_material(~stm);
+        if (materialized < plies)
+            materialize(board);
+
+        const sf::Eval::NNUE::Position pos(board);
+        const Color stm = board.side_to_move();
+        const int simpleEval = sf::PawnValue * (pawn_count(board, stm) - pawn_count(board, ~stm)) +
+                               non_pawn_material(board, stm) - non_pawn_material(board, ~stm);
 
         bool useSmall = std::abs(simpleEval) > 962;
 
@@ -316,77 +359,95 @@ class SfContext {
         optimism += optimism * nnueComplexity / 476;
         nnue -= nnue * nnueComplexity / 18236;
 
-        const int material = 534 * pos.count<sf::PAWN>() + pos.non_pawn_material();
+        const int material = 534 * (pawn_count(board, White) + pawn_count(board, Black)) +
+                             non_pawn_material(board, White) + non_pawn_material(board, Black);
         int v = (int(nnue) * (77871 + material) + optimism * (7191 + material)) / 77871;
 
-        v -= v * pos.rule50_count() / 199;
+        v -= v * board.halfmove_clock() / 199;
         v = std::clamp(v, int(sf::VALUE_TB_LOSS_IN_MAX_PLY) + 1,
                        int(sf::VALUE_TB_WIN_IN_MAX_PLY) - 1);
 
         return v;
     }
 
+    UpdateCounts update_counts() const override {
+        return counts;
+    }
+
    private:
-    static constexpr std::size_t MaxPly = 256;
+    static constexpr std::size_t MaxPlies = sf::Eval::NNUE::AccumulatorStack::MaxSize;
+
+    // A made move that is not on the accumulator stack yet
+    struct PendingMove {
+        DirtyPiece dirtyPiece;
+        Color us;
+        Square prevKsq;
+        Square ksq;
+    };
+
+    // Pushes the pending moves onto the accumulator stack. Their threat changes are taken
+    // from a scratch board walked back from the current position, newest move first.
+    void materialize(const Board& board) {
+        for (std::size_t ply = materialized; ply < plies; ++ply) {
+            auto [sfDirtyPiece, sfDirtyThreats] = accumulators.push();
+            pushedPieces[ply] = &sfDirtyPiece;
+            pushedThreats[ply] = &sfDirtyThreats;
+        }
+
+        Board scratch = board;
+        for (std::size_t ply = plies; ply-- > materialized;) {
+            const PendingMove& move = pending[ply];
+            threats.clear();
+            threats.us = move.us;
+            threats.prevKsq = move.prevKsq;
+            threats.ksq = move.ksq;
+            if (!unwind_move_threats(scratch, move.dirtyPiece, threats)) {
+                reset(board);
+                return;
+            }
+            *pushedPieces[ply] = to_sf_dirty_piece(move.dirtyPiece);
+            to_sf_dirty_threats(threats, *pushedThreats[ply]);
+        }
+        if constexpr (SEARCH_STATS_ENABLED)
+            counts.incremental += plies - materialized;
+        materialized = plies;
+    }
+
+    static int pawn_count(const Board& board, Color c) {
+        return popcount(board.pieces(c, Pawn));
+    }
+
+    // Stockfish's non_pawn_material(), in its piece values
+    static int non_pawn_material(const Board& board, Color c) {
+        return sf::KnightValue * popcount(board.pieces(c, Knight)) +
+               sf::BishopValue * popcount(board.pieces(c, Bishop)) +
+               sf::RookValue * popcount(board.pieces(c, Rook)) +
+               sf::QueenValue * popcount(board.pieces(c, Queen));
+    }
 
-    sf::Position pos;
-    std::vector<sf::StateInfo> states;
-    std::vector<sf::Move> moves;
     sf::Eval::NNUE::AccumulatorStack accumulators;
-    std::unique_ptr<sf::Eval::NNUE::AccumulatorCaches> caches;
+    CachesPtr caches;
+    std::array<PendingMove, MaxPlies> pending;
+    std::array<sf::DirtyPiece*, MaxPlies> pushedPieces{};
+    std::array<sf::DirtyThreats*, MaxPlies> pushedThreats{};
+    DirtyThreats threats;  // scratch list for the move being pushed
+    std::size_t plies = 0;         // moves made since reset()
+    std::size_t materialized = 0;  // of those, moves already on the accumulator stack
     bool synced = false;
     uint64_t syncedHash = 0;
+    UpdateCounts counts;
 };
 
 }  // namespace
-
-struct SearchNnueContext::Impl {
-    SfContext ctx;
+}  // namespace PANDA_NNUE_IMPL
+
+extern const Kernel PANDA_NNUE_CAT(kernel_, PANDA_NNUE_KERNEL) = {
+    PANDA_NNUE_STR(PANDA_NNUE_KERNEL),
+    PANDA_NNUE_IMPL::ensure_backend,
+    []() -> std::unique_ptr<KernelContext> {
+        return std::make_unique<PANDA_NNUE_IMPL::BoardContext>();
+    },
+    PANDA_NNUE_IMPL::preallocate,
 };
 
-SearchNnueContext::SearchNnueContext() : impl(std::make_unique<Impl>()) {}
-
-SearchNnueContext::~SearchNnueContext() = default;
-
-SearchNnueContext::SearchNnueContext(SearchNnueContext&&) noexcept = default;
-
-SearchNnueContext& SearchNnueContext::operator=(SearchNnueContext&&) noexcept = default;
-
-void SearchNnueContext::reset(const Board& board) {
-    impl->ctx.reset(board);
-}
-
-void SearchNnueContext::on_make_move(const Board& board, Move m, const DirtyPiece& dirtyPiece,
-                                     const DirtyThreats& dirtyThreats) {
-    impl->ctx.on_make_move(board, m, dirtyPiece, dirtyThreats);
-}
-
-void SearchNnueContext::on_unmake_move(const Board& board) {
-    impl->ctx.on_unmake_move(board);
-}
-
-void SearchNnueContext::on_null_move(const Board& board) {
-    impl->ctx.on_null_move(board);
-}
-
-void SearchNnueContext::on_unmake_null_move(const Board& board) {
-    impl->ctx.on_unmake_null_move(board);
-}
-
-int SearchNnueContext::evaluate(const Board& board) {
-    return impl->ctx.evaluate(board);
-}
-
-bool SearchNnueContext::is_available() const {
-    return impl->ctx.available();
-}
-
-bool SearchNnueContext::is_loaded() const {
-    return backend_loaded();
-}
-
-bool backend_loaded() {
-    return ensure_backend();
-}
-
 }  // namespace panda::nnue
@@ -36,11 +36,12 @@ struct DirtyThreat {
                (uint32_t(threatenedSq) << ThreatenedSqOffset) | (uint32_t(pcSq) << PcSqOffset);
     }
 
+    // Pieces take four bits each, so the attacked piece must not read into the attacker's
     Piece pc() const {
-        return Piece((data >> PcOffset) & 0xFFu);
+        return Piece((data >> PcOffset) & 0xFu);
     }
     Piece threatened_pc() const {
-        return Piece((data >> ThreatenedPcOffset) & 0xFFu);
+        return Piece((data >> ThreatenedPcOffset) & 0xFu);
     }
     Square threatened_sq() const {
         return Square((data >> ThreatenedSqOffset) & 0xFFu);
@@ -72,6 +73,12 @@ struct DirtyThreatList {
         if (count < MaxSize)
             values[count++] = value;
     }
+    DirtyThreat* begin() {
+        return values;
+    }
+    DirtyThreat* end() {
+        return values + count;
+    }
     const DirtyThreat* begin() const {
         return values;
     }
@@ -108,6 +115,25 @@ struct DirtyThreats {
     }
 };
 
+// Appends to dirtyThreats.list the threat features (attacker/attacked pairs) that the move
+// described by `dirtyPiece` added or removed. `board` is the position after the move.
+// Returns false if the list overflowed, in which case the accumulators must be refreshed.
+bool append_move_threats(const Board& board, const DirtyPiece& dirtyPiece,
+                         DirtyThreats& dirtyThreats);
+
+// Same, for a board that is then stepped back: on return `board` holds the piece placement
+// from before the move (side to move, castling and the like are left untouched).
+bool unwind_move_threats(Board& board, const DirtyPiece& dirtyPiece, DirtyThreats& dirtyThreats);
+
+class KernelContext;
+
+// Accumulator work done by one context. Counted only in PANDA_SEARCH_STATS builds.
+struct UpdateCounts {
+    uint64_t refreshes = 0;    // accumulator stack resets
+    uint64_t incremental = 0;  // moves pushed onto the stack
+};
+
+// Accumulators of one search thread, backed by the kernel set chosen at startup.
 class SearchNnueContext {
    public:
     SearchNnueContext();
@@ -129,13 +155,20 @@ class SearchNnueContext {
     int evaluate(const Board& board);
     bool is_available() const;
     bool is_loaded() const;
+    UpdateCounts update_counts() const;
 
    private:
-    struct Impl;
-    std::unique_ptr<Impl> impl;
+    std::unique_ptr<KernelContext> impl;
 };
 
 bool backend_loaded();
 
+// Loads the nets (blocking until done) and preallocates accumulator caches for
+// `threadCount` search threads, so neither is paid for at the start of a search.
+void preallocate_contexts(int threadCount);
+
+// Name of the NNUE kernel set in use (e.g. "avx2"), picked once from the CPU's features.
+const char* kernel_name();
+
 }  // namespace nnue
 }  // namespace panda
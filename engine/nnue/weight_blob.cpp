@@ -0,0 +1,156 @@
+#include "nnue/weight_blob.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PANDA_WEIGHT_BLOB_MMAP
+#endif
+
+namespace panda::nnue {
+
+static_assert(sizeof(WeightBlobHeader) <= WeightBlobHeader::PayloadOffset);
+
+static bool header_matches(const WeightBlobHeader& found, const WeightBlobHeader& expected) {
+    return std::memcmp(found.magic, expected.magic, sizeof(found.magic)) == 0 &&
+           found.version == expected.version &&
+           std::strncmp(found.kernel, expected.kernel, sizeof(found.kernel)) == 0 &&
+           found.payloadSize == expected.payloadSize &&
+           (!expected.bigNetHash || found.bigNetHash == expected.bigNetHash) &&
+           (!expected.smallNetHash || found.smallNetHash == expected.smallNetHash);
+}
+
+// FNV-1a over 64-bit words, with a shift so high bits also reach the low ones, in four
+// interleaved lanes so the multiplies overlap. It only has to tell nets apart, not resist
+// tampering, and is quick enough that mapping a blob stays far cheaper than parsing the nets.
+uint64_t file_content_hash(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return 0;
+
+    constexpr uint64_t Prime = 0x100000001B3ULL;
+    auto mix = [](uint64_t hash, uint64_t word) {
+        hash = (hash ^ word) * Prime;
+        return hash ^ (hash >> 29);
+    };
+
+    uint64_t lanes[4] = {0xCBF29CE484222325ULL, 1, 2, 3};
+    uint64_t size = 0;
+    std::vector<char> buffer(1 << 20);  // a multiple of the 32 bytes the lanes take per step
+    while (in) {
+        in.read(buffer.data(), std::streamsize(buffer.size()));
+        const std::size_t got = std::size_t(in.gcount());
+        std::size_t i = 0;
+        for (; i + 32 <= got; i += 32) {
+            uint64_t words[4];
+            std::memcpy(words, buffer.data() + i, sizeof(words));
+            for (int lane = 0; lane < 4; ++lane) lanes[lane] = mix(lanes[lane], words[lane]);
+        }
+        for (; i < got; ++i) lanes[0] = mix(lanes[0], uint8_t(buffer[i]));
+        size += got;
+    }
+    if (in.bad())
+        return 0;
+
+    uint64_t hash = mix(lanes[0], size);
+    for (int lane = 1; lane < 4; ++lane) hash = mix(hash, lanes[lane]);
+    return hash ? hash : 1;
+}
+
+WeightBlob::~WeightBlob() {
+    release();
+}
+
+WeightBlob::WeightBlob(WeightBlob&& other) noexcept
+    : base(std::exchange(other.base, nullptr)), length(std::exchange(other.length, 0)) {}
+
+WeightBlob& WeightBlob::operator=(WeightBlob&& other) noexcept {
+    if (this != &other) {
+        release();
+        base = std::exchange(other.base, nullptr);
+        length = std::exchange(other.length, 0);
+    }
+    return *this;
+}
+
+void WeightBlob::release() {
+#ifdef PANDA_WEIGHT_BLOB_MMAP
+    if (base)
+        munmap(base, length);
+#endif
+    base = nullptr;
+    length = 0;
+}
+
+WeightBlob WeightBlob::map(const std::string& path, const WeightBlobHeader& expected) {
+    WeightBlob blob;
+#ifdef PANDA_WEIGHT_BLOB_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return blob;
+
+    struct stat st;
+    const std::size_t wanted = WeightBlobHeader::PayloadOffset + expected.payloadSize;
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) != wanted) {
+        close(fd);
+        return blob;
+    }
+
+    void* base = mmap(nullptr, wanted, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // the mapping keeps the file open
+    if (base == MAP_FAILED)
+        return blob;
+
+    blob.base = base;
+    blob.length = wanted;
+    if (!header_matches(*static_cast<const WeightBlobHeader*>(base), expected))
+        blob.release();
+#else
+    (void)path;
+    (void)expected;
+#endif
+    return blob;
+}
+
+bool WeightBlob::write(const std::string& path, const WeightBlobHeader& header,
+                       const void* payload) {
+#ifdef PANDA_WEIGHT_BLOB_MMAP
+    const std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        std::vector<char> head(WeightBlobHeader::PayloadOffset, 0);
+        std::memcpy(head.data(), &header, sizeof(header));
+        out.write(head.data(), std::streamsize(head.size()));
+        out.write(static_cast<const char*>(payload), std::streamsize(header.payloadSize));
+        if (!out.flush()) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+#else
+    (void)path;
+    (void)header;
+    (void)payload;
+    return false;
+#endif
+}
+
+}  // namespace panda::nnue
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace panda::nnue {
+
+// A weight blob is the in-memory image of a kernel set's loaded networks: the SIMD-specific
+// weight permutations are already applied, so it is used in place without parsing. The
+// payload starts on a page boundary after this header.
+struct WeightBlobHeader {
+    static constexpr uint32_t CurrentVersion = 2;
+    static constexpr std::size_t PayloadOffset = 4096;
+
+    char magic[8] = {'P', 'A', 'N', 'D', 'A', 'N', 'N', '\0'};
+    uint32_t version = CurrentVersion;
+    char kernel[20] = {};     // kernel set the weights were laid out for
+    uint64_t payloadSize = 0;
+    uint64_t bigNetHash = 0;  // file_content_hash() of the source .nnue files; 0 when not checked
+    uint64_t smallNetHash = 0;
+};
+
+// Hash of the file's bytes, so a blob goes stale when a net is replaced by another of the same
+// size. Returns 0 if the file cannot be read.
+uint64_t file_content_hash(const std::string& path);
+
+// Read-only shared mapping of a weight blob file. Every process that maps the same blob
+// shares one copy of the weights in the page cache.
+class WeightBlob {
+   public:
+    WeightBlob() = default;
+    ~WeightBlob();
+
+    WeightBlob(const WeightBlob&) = delete;
+    WeightBlob& operator=(const WeightBlob&) = delete;
+    WeightBlob(WeightBlob&& other) noexcept;
+    WeightBlob& operator=(WeightBlob&& other) noexcept;
+
+    // Maps `path` if its header matches `expected` (net hashes only when nonzero there).
+    // Returns an empty blob if the file is missing, stale or mapping is unsupported.
+    static WeightBlob map(const std::string& path, const WeightBlobHeader& expected);
+
+    // Writes a blob next to `path` and renames it into place, so a concurrently starting
+    // process maps either no blob or a complete one.
+    static bool write(const std::string& path, const WeightBlobHeader& header,
+                      const void* payload);
+
+    const void* payload() const {
+        return static_cast<const char*>(base) + WeightBlobHeader::PayloadOffset;
+    }
+    explicit operator bool() const {
+        return base != nullptr;
+    }
+
+   private:
+    void release();
+
+    void* base = nullptr;
+    std::size_t length = 0;
+};
+
+}  // namespace panda::nnue
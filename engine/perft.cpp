@@ -0,0 +1,215 @@
+#include "perft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "movegen.h"
+
+namespace panda {
+
+static constexpr size_t DEFAULT_HASH_MB = 64;
+static constexpr int MAX_DEPTH = 20;
+
+// Subtree counts keyed by position and remaining depth, shared by all perft workers. An
+// entry is two relaxed atomic words, the key stored XORed with the count: a probe that
+// reads halves of two different stores fails the key check instead of returning a wrong
+// count, so no locks are needed.
+class PerftHash {
+   public:
+    explicit PerftHash(size_t sizeMB) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Entry) <= sizeMB * 1024 * 1024) count *= 2;
+        mask = count - 1;
+        entries.reset(new Entry[count]);
+    }
+
+    static uint64_t key_for(const Board& board, int depth) {
+        return board.hash_key() ^ (uint64_t(depth) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    bool probe(uint64_t key, uint64_t& nodes) const {
+        const Entry& e = entries[key & mask];
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+        uint64_t count = e.nodes.load(std::memory_order_relaxed);
+        if ((check ^ count) != key)
+            return false;
+        nodes = count;
+        return true;
+    }
+
+    void store(uint64_t key, uint64_t nodes) {
+        Entry& e = entries[key & mask];
+        e.check.store(key ^ nodes, std::memory_order_relaxed);
+        e.nodes.store(nodes, std::memory_order_relaxed);
+    }
+
+   private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> nodes{0};
+    };
+    std::unique_ptr<Entry[]> entries;
+    size_t mask = 0;
+};
+
+static bool stopRequested(const std::atomic<bool>* stop) {
+    return stop && stop->load(std::memory_order_relaxed);
+}
+
+// Returns a partial count once `stop` is raised; the caller discards it.
+static uint64_t countNodes(Board& board, int depth, PerftHash* hash, bool bulk,
+                           const std::atomic<bool>* stop) {
+    if (depth == 0)
+        return 1;
+    if (stopRequested(stop))
+        return 0;
+
+    // One-ply subtrees are cheaper to count than to look up
+    uint64_t key = 0;
+    if (hash && depth >= 2) {
+        key = PerftHash::key_for(board, depth);
+        uint64_t cached;
+        if (hash->probe(key, cached))
+            return cached;
+    }
+
+    MoveList moves = generate_legal(board);
+    if (depth == 1 && bulk)
+        return moves.size();
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < moves.size(); ++i) {
+        Board::UndoInfo undo;
+        board.make_move(moves[i], undo);
+        nodes += countNodes(board, depth - 1, hash, bulk, stop);
+        board.unmake_move(moves[i], undo);
+    }
+
+    // A partial count must not be reused by the workers still finishing their moves
+    if (hash && depth >= 2 && !stopRequested(stop))
+        hash->store(key, nodes);
+    return nodes;
+}
+
+PerftResult perft_divide(const Board& board, int depth, const PerftOptions& options) {
+    PerftResult result;
+    if (depth <= 0) {
+        result.nodes = 1;
+        return result;
+    }
+
+    MoveList moves = generate_legal(board);
+    std::vector<uint64_t> counts(moves.size(), 0);
+    std::unique_ptr<PerftHash> hash;
+    if (options.hashMB > 0 && depth >= 3)
+        hash = std::make_unique<PerftHash>(options.hashMB);
+
+    // Root moves differ a lot in subtree size, so workers take the next one as they finish
+    // rather than a fixed share.
+    std::atomic<int> nextMove{0};
+    auto worker = [&]() {
+        Board copy = board;
+        for (int i = nextMove.fetch_add(1); i < moves.size() && !stopRequested(options.stop);
+             i = nextMove.fetch_add(1)) {
+            Board::UndoInfo undo;
+            copy.make_move(moves[i], undo);
+            counts[i] = countNodes(copy, depth - 1, hash.get(), options.bulk, options.stop);
+            copy.unmake_move(moves[i], undo);
+        }
+    };
+
+    const int threadCount = std::clamp(options.threads, 1, std::max(moves.size(), 1));
+    std::vector<std::thread> helpers;
+    for (int t = 1; t < threadCount; ++t) helpers.emplace_back(worker);
+    worker();
+    for (std::thread& t : helpers) t.join();
+
+    for (int i = 0; i < moves.size(); ++i) {
+        result.nodes += counts[i];
+        result.divide.emplace_back(moves[i], counts[i]);
+    }
+    result.stopped = stopRequested(options.stop);
+    return result;
+}
+
+uint64_t perft_command(const Board& board, std::istream& args, std::ostream& out, bool divide,
+                       const std::atomic<bool>* stop) {
+    int depth = 1;
+    int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int hashMB = static_cast<int>(DEFAULT_HASH_MB);
+    bool bulk = true;
+    Board position = board;
+
+    // Numbers fill depth, threads and hash in that order; words may appear anywhere
+    int numbersRead = 0;
+    std::string token;
+    while (args >> token) {
+        if (token == "full") {
+            bulk = false;
+        } else if (token == "bulk") {
+            bulk = true;
+        } else if (token == "fen") {
+            std::string fen;
+            for (int i = 0; i < 6 && (args >> token); ++i) {
+                if (i > 0)
+                    fen += ' ';
+                fen += token;
+            }
+            position.set_fen(fen);
+        } else {
+            int value;
+            try {
+                value = std::stoi(token);
+            } catch (...) {
+                continue;
+            }
+            if (numbersRead == 0)
+                depth = value;
+            else if (numbersRead == 1)
+                threads = value;
+            else if (numbersRead == 2)
+                hashMB = value;
+            ++numbersRead;
+        }
+    }
+    depth = std::clamp(depth, 1, MAX_DEPTH);
+    threads = std::clamp(threads, 1, 256);
+    hashMB = std::clamp(hashMB, 0, 4096);
+
+    out << (divide ? "divide" : "perft") << ": depth " << depth << ", threads " << threads
+        << ", hash " << hashMB << " MB, " << (bulk ? "bulk" : "full") << " leaf counting"
+        << std::endl;
+
+    PerftOptions options;
+    options.threads = threads;
+    options.hashMB = static_cast<size_t>(hashMB);
+    options.bulk = bulk;
+    options.stop = stop;
+
+    auto start = std::chrono::steady_clock::now();
+    PerftResult result = perft_divide(position, depth, options);
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+    if (result.stopped) {
+        out << "Stopped, counts are partial" << std::endl;
+    } else if (divide) {
+        for (const auto& [move, nodes] : result.divide)
+            out << move_to_uci(move) << ": " << nodes << std::endl;
+        out << std::endl;
+    }
+    out << "Nodes searched  : " << result.nodes << std::endl;
+    out << "Total time (ms) : " << ms << std::endl;
+    out << "Nodes/second    : " << result.nodes * 1000 / uint64_t(std::max<int64_t>(ms, 1))
+        << std::endl;
+    return result.nodes;
+}
+
+}  // namespace panda
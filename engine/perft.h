@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+
+namespace panda {
+
+struct PerftOptions {
+    int threads = 1;
+    size_t hashMB = 0;  // subtree count cache; 0 disables it
+    bool bulk = true;   // count the last ply from the move list instead of making each move
+    const std::atomic<bool>* stop = nullptr;  // raised to abandon the count early
+};
+
+struct PerftResult {
+    uint64_t nodes = 0;
+    std::vector<std::pair<Move, uint64_t>> divide;  // leaf count under each root move
+    bool stopped = false;                           // counts are partial
+};
+
+// Counts the leaf nodes `depth` plies below `board`. Root moves are handed out to worker
+// threads one at a time; with a hash, subtree counts are shared between the workers and
+// reused across transpositions.
+PerftResult perft_divide(const Board& board, int depth, const PerftOptions& options);
+
+// The "perft" and "divide" commands: `<depth> [threads] [hashMB] [full] [fen <fen>]`.
+// Defaults are one thread per core and a 64 MB hash; `full` makes and unmakes every leaf
+// move instead of bulk counting. `divide` also prints the count under each root move.
+// Raising `stop` ends the count early; only the partial totals are printed then.
+uint64_t perft_command(const Board& board, std::istream& args, std::ostream& out, bool divide,
+                       const std::atomic<bool>* stop = nullptr);
+
+}  // namespace panda
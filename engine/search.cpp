@@ -4,7 +4,11 @@
 #include <chrono>
 #include <climits>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -12,46 +16,164 @@
 #include "eval.h"
 #include "movegen.h"
 #include "nnue/panda_nnue.h"
+#include "search_stats.h"
 
 namespace panda {
 
+// Node count of one search thread. Only the owning thread writes it, with a plain load and
+// store rather than a locked read-modify-write; the alignment gives every counter its own
+// cache line, so the main thread summing them never contends with a searching thread.
+struct alignas(64) NodeCounter {
+    std::atomic<uint64_t> count{0};
+
+    void increment() {
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    uint64_t load() const {
+        return count.load(std::memory_order_relaxed);
+    }
+    void reset() {
+        count.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Nodes between polls of the clock and the external stop flag. At our slowest NNUE speeds
+// (~1M nodes/s per thread) this keeps stop latency around half a millisecond.
+constexpr int TIME_CHECK_INTERVAL = 512;
+
+// Static evaluations of recently seen positions. Each search thread owns one, so it needs no
+// synchronisation; it is direct-mapped and a store simply replaces whatever was there. The
+// fifty-move counter is folded into the key because the NNUE score is damped as it grows.
+class EvalCache {
+   public:
+    static constexpr size_t ENTRY_COUNT = size_t(1) << 16;  // 1 MB
+
+    EvalCache() : entries(new Entry[ENTRY_COUNT]()) {}
+
+    static uint64_t key_for(const Board& board) {
+        return board.hash_key() ^ (uint64_t(board.halfmove_clock()) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    bool probe(uint64_t key, int& eval) const {
+        const Entry& e = entries[key & (ENTRY_COUNT - 1)];
+        if (e.key != key)
+            return false;
+        eval = e.eval;
+        return true;
+    }
+
+    void store(uint64_t key, int eval) {
+        entries[key & (ENTRY_COUNT - 1)] = {key, eval};
+    }
+
+    void clear() {
+        std::fill_n(entries.get(), ENTRY_COUNT, Entry{});
+    }
+
+   private:
+    struct Entry {
+        uint64_t key;
+        int eval;
+    };
+    std::unique_ptr<Entry[]> entries;
+};
+
 struct SearchState {
-    TranspositionTable& tt;
+    TranspositionTable* tt;
     Move killers[MAX_PLY][2];  // 2 killer moves per ply
     int history[2][64][64];    // [color][from][to] history scores
     std::vector<uint64_t> repetitionHistory;
     int rootRepIndex;
     std::chrono::steady_clock::time_point startTime;
-    int timeLimitMs;
+    int timeLimitMs;  // 0 = no deadline; under SMP only the main thread has one
+    int timeCheckCountdown;
     bool stopped;
     std::atomic<bool>* externalStop;  // set by UCI "stop" command
-    uint64_t nodes;
-    std::atomic<uint64_t>* sharedNodes;  // shared across all SMP threads
+    NodeCounter ownNodes;
+    NodeCounter* nodes;  // ownNodes, or this thread's slot in the SMP counter array
+    uint64_t rootNodes;          // nodes below the root in the last searchRoot call
+    uint64_t rootBestMoveNodes;  // ... of which below its best move
     nnue::SearchNnueContext nnueCtx;
+    EvalCache evalCache;
+    EvalMode evalCacheMode = get_eval_mode();  // the mode the cached evals were computed in
+    SearchStats stats;
+    nnue::UpdateCounts nnueCountsMerged;  // NNUE work already merged into the stats totals
 
     explicit SearchState(TranspositionTable& tt_, std::atomic<bool>* extStop = nullptr,
-                         std::atomic<uint64_t>* shared = nullptr)
-        : tt(tt_),
+                         NodeCounter* counter = nullptr)
+        : tt(&tt_),
           rootRepIndex(0),
           timeLimitMs(0),
+          timeCheckCountdown(TIME_CHECK_INTERVAL),
           stopped(false),
           externalStop(extStop),
-          nodes(0),
-          sharedNodes(shared) {
-        clear();
+          nodes(counter ? counter : &ownNodes) {
+        resetSearch();
+        std::memset(history, 0, sizeof(history));
     }
 
-    void clear() {
-        std::memset(killers, 0, sizeof(killers));
+    ~SearchState() {
+        mergeStats();
+    }
+
+    // Prepares a pooled state for the next search of the game. History carries over, halved
+    // so the latest search weighs most; killers are indexed by ply from the old root and are
+    // dropped. The eval cache stays valid until the eval mode changes.
+    void attach(TranspositionTable& tt_, std::atomic<bool>* extStop, NodeCounter* counter) {
+        tt = &tt_;
+        externalStop = extStop;
+        nodes = counter ? counter : &ownNodes;
+        resetSearch();
+        for (auto& side : history) {
+            for (auto& from : side) {
+                for (int& score : from) score /= 2;
+            }
+        }
+        if (evalCacheMode != get_eval_mode()) {
+            evalCache.clear();
+            evalCacheMode = get_eval_mode();
+        }
+    }
+
+    // Forgets what earlier searches learned, for a new game
+    void clearHeuristics() {
         std::memset(history, 0, sizeof(history));
+        evalCache.clear();
+    }
+
+    // Adds the counters since the last merge to the process totals; called when a search ends
+    void mergeStats() {
+        if constexpr (SEARCH_STATS_ENABLED) {
+            nnue::UpdateCounts nnueCounts = nnueCtx.update_counts();
+            const nnue::UpdateCounts& merged = nnueCountsMerged;
+            stats.add(SearchStat::NnueRefreshes, nnueCounts.refreshes - merged.refreshes);
+            stats.add(SearchStat::NnueUpdates, nnueCounts.incremental - merged.incremental);
+            nnueCountsMerged = nnueCounts;
+            merge_search_stats(stats);
+            stats = SearchStats{};
+        }
+    }
+
+    void resetSearch() {
+        std::memset(killers, 0, sizeof(killers));
         stopped = false;
-        nodes = 0;
+        timeCheckCountdown = TIME_CHECK_INTERVAL;
+        nodes->reset();
+        rootNodes = 0;
+        rootBestMoveNodes = 0;
         repetitionHistory.clear();
         rootRepIndex = 0;
     }
 
+    // Called at every node but only polls every TIME_CHECK_INTERVAL nodes. The thread
+    // that owns the deadline raises the external stop flag when it expires, which is how
+    // SMP helpers (which have no deadline of their own) learn to stop.
     bool checkTime() {
-        // Check external stop flag (from UCI "stop")
+        if (--timeCheckCountdown > 0)
+            return false;
+        timeCheckCountdown = TIME_CHECK_INTERVAL;
+
+        // Check external stop flag (from UCI "stop" or the main search thread)
         if (externalStop && externalStop->load(std::memory_order_relaxed)) {
             stopped = true;
             return true;
@@ -63,6 +185,8 @@ struct SearchState {
             std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
         if (elapsed >= timeLimitMs) {
             stopped = true;
+            if (externalStop)
+                externalStop->store(true, std::memory_order_relaxed);
             return true;
         }
         return false;
@@ -99,14 +223,26 @@ static bool isThreefoldRepetition(const Board& board, const SearchState& state,
     return false;
 }
 
+// Static evaluation through the thread's eval cache. Transpositions and re-searches of the
+// same node in later iterations then skip the NNUE forward pass.
+static int staticEvaluate(const Board& board, SearchState& state) {
+    uint64_t key = EvalCache::key_for(board);
+    int eval;
+    state.stats.add(SearchStat::Evals);
+    if (state.evalCache.probe(key, eval)) {
+        state.stats.add(SearchStat::EvalCacheHits);
+        return eval;
+    }
+    eval = evaluate(board, &state.nnueCtx);
+    state.evalCache.store(key, eval);
+    return eval;
+}
+
 // ============================================================
 // Move ordering
 // ============================================================
 
-static constexpr int TT_MOVE_SCORE = 10000000;
 static constexpr int CAPTURE_BASE = 1000000;
-static constexpr int KILLER1_SCORE = 900000;
-static constexpr int KILLER2_SCORE = 800000;
 
 // Delta pruning margin: a small safety buffer beyond the captured piece value
 static constexpr int DELTA_MARGIN = 200;
@@ -221,6 +357,7 @@ static int staticExchangeEval(const Board& board, Move m) {
     int gain[32];
     gain[0] = capturedValue + promotionGain;
     int depth = 0;
+    PieceType onSquarePt = placedPt;  // piece the next recapture would win
     Color stm = them;
 
     while (true) {
@@ -231,14 +368,19 @@ static int staticExchangeEval(const Board& board, Move m) {
         if (!pickLeastValuableAttacker(pieces, stm, attackers, attackerFrom, attackerPt))
             break;
 
+        // The king may only recapture when the other side has nothing left to retake with.
+        if (attackerPt == King && attackersToSquare(pieces, occupied, to, ~stm))
+            break;
+
         ++depth;
-        gain[depth] = PieceValue[attackerPt] - gain[depth - 1];
+        gain[depth] = PieceValue[onSquarePt] - gain[depth - 1];
         if (std::max(-gain[depth - 1], gain[depth]) < 0)
             break;
 
         Bitboard attackerFromBB = square_bb(attackerFrom);
         pieces[stm][attackerPt] ^= attackerFromBB;
         occupied ^= attackerFromBB;
+        onSquarePt = attackerPt;
         stm = ~stm;
     }
 
@@ -252,12 +394,13 @@ static int mvvLvaScore(const Board& board, Move m) {
     Square to = move_to(m);
     Square from = move_from(m);
 
-    int victimVal;
+    int victimVal = 0;
     if (move_type(m) == EnPassant) {
         victimVal = PieceValue[Pawn];
     } else {
         Piece victim = board.piece_on(to);
-        victimVal = PieceValue[piece_type(victim)];
+        if (victim != NoPiece)
+            victimVal = PieceValue[piece_type(victim)];
     }
 
     Piece attacker = board.piece_on(from);
@@ -266,38 +409,20 @@ static int mvvLvaScore(const Board& board, Move m) {
     return CAPTURE_BASE + victimVal * 10 - attackerVal;
 }
 
-static int captureScore(const Board& board, Move m) {
+static int captureScore(const Board& board, Move m, int see) {
     // SEE dominates tactical ordering; MVV-LVA keeps stable tie-breaks.
-    int see = staticExchangeEval(board, m);
     return CAPTURE_BASE + see * 64 + mvvLvaScore(board, m);
 }
 
-static void scoreMoves(const Board& board, MoveList& moves, int* scores, Move ttMove,
-                       const SearchState& state, int ply) {
-    Color side = board.side_to_move();
-    for (int i = 0; i < moves.size(); ++i) {
-        Move m = moves[i];
-
-        if (m == ttMove && ttMove != NullMove) {
-            scores[i] = TT_MOVE_SCORE;
-        } else if (isCapture(board, m)) {
-            scores[i] = captureScore(board, m);
-        } else if (ply < MAX_PLY && m == state.killers[ply][0]) {
-            scores[i] = KILLER1_SCORE;
-        } else if (ply < MAX_PLY && m == state.killers[ply][1]) {
-            scores[i] = KILLER2_SCORE;
-        } else {
-            // History heuristic
-            scores[i] = state.history[side][move_from(m)][move_to(m)];
-        }
-    }
+static int captureScore(const Board& board, Move m) {
+    return captureScore(board, m, staticExchangeEval(board, m));
 }
 
-// Incremental selection: pick the best-scored move at position idx and swap it in
-static void pickBest(MoveList& moves, int* scores, int idx) {
+// Incremental selection: pick the best-scored move in [idx, end) and swap it to idx
+static void pickBest(MoveList& moves, int* scores, int idx, int end) {
     int bestIdx = idx;
     int bestScore = scores[idx];
-    for (int i = idx + 1; i < moves.size(); ++i) {
+    for (int i = idx + 1; i < end; ++i) {
         if (scores[i] > bestScore) {
             bestScore = scores[i];
             bestIdx = i;
@@ -309,13 +434,164 @@ static void pickBest(MoveList& moves, int* scores, int idx) {
     }
 }
 
-// Score captures only (for quiescence search)
-static void scoreCapturesMvvLva(const Board& board, MoveList& moves, int* scores) {
-    for (int i = 0; i < moves.size(); ++i) {
-        scores[i] = captureScore(board, moves[i]);
-    }
+// ============================================================
+// Staged move picker
+// ============================================================
+//
+// Hands out moves one at a time in search order. Each stage is prepared only when it
+// is reached, so a cutoff on the TT move costs a single legality check: no list
+// generation and no SEE. Quiets are not generated until the captures and killers
+// have failed to cut.
+//
+// Main search order: TT move, good captures (SEE >= 0), killers, quiets by history,
+// bad captures (SEE < 0). Promotions are treated as captures.
+
+enum class PickStage : uint8_t {
+    TTMove,
+    InitCaptures,
+    GoodCaptures,
+    Killers,
+    InitQuiets,
+    Quiets,
+    BadCaptures,
+    QCaptures,
+    Done
+};
+
+static bool isTactical(const Board& board, Move m) {
+    return isCapture(board, m) || move_type(m) == Promotion;
 }
 
+class MovePicker {
+   public:
+    // Main search constructor.
+    MovePicker(const Board& board, Move ttMove, const SearchState& state, int ply)
+        : board(board), state(&state), ttMove(ttMove), stage(PickStage::TTMove) {
+        if (ply < MAX_PLY) {
+            killers[0] = state.killers[ply][0];
+            killers[1] = state.killers[ply][1];
+        }
+    }
+
+    // Quiescence constructor: yields the given moves ordered by capture score.
+    MovePicker(const Board& board, const MoveList& moves)
+        : board(board), state(nullptr), ttMove(NullMove), stage(PickStage::QCaptures) {
+        captures = moves;
+        for (int i = 0; i < captures.size(); ++i)
+            captureScores[i] = captureScore(board, captures[i]);
+    }
+
+    Move next() {
+        switch (stage) {
+            case PickStage::TTMove:
+                stage = PickStage::InitCaptures;
+                if (ttMove != NullMove && is_legal(board, ttMove))
+                    return ttMove;
+                [[fallthrough]];
+
+            case PickStage::InitCaptures:
+                captures = generate_legal(board, GenType::Captures);
+                scoreCaptures();
+                stage = PickStage::GoodCaptures;
+                [[fallthrough]];
+
+            case PickStage::GoodCaptures:
+                while (captureIdx < goodEnd) {
+                    pickBest(captures, captureScores, captureIdx, goodEnd);
+                    Move m = captures[captureIdx++];
+                    if (m != ttMove)
+                        return m;
+                }
+                stage = PickStage::Killers;
+                [[fallthrough]];
+
+            case PickStage::Killers:
+                while (killerIdx < 2) {
+                    Move k = killers[killerIdx++];
+                    if (k == NullMove || k == ttMove || (killerIdx == 2 && k == killers[0]))
+                        continue;
+                    if (!isTactical(board, k) && is_legal(board, k))
+                        return k;
+                }
+                stage = PickStage::InitQuiets;
+                [[fallthrough]];
+
+            case PickStage::InitQuiets: {
+                quiets = generate_legal(board, GenType::Quiets);
+                const auto& history = state->history[board.side_to_move()];
+                for (int i = 0; i < quiets.size(); ++i)
+                    quietScores[i] = history[move_from(quiets[i])][move_to(quiets[i])];
+                stage = PickStage::Quiets;
+                [[fallthrough]];
+            }
+
+            case PickStage::Quiets:
+                while (quietIdx < quiets.size()) {
+                    pickBest(quiets, quietScores, quietIdx, quiets.size());
+                    Move m = quiets[quietIdx++];
+                    if (m != ttMove && m != killers[0] && m != killers[1])
+                        return m;
+                }
+                stage = PickStage::BadCaptures;
+                [[fallthrough]];
+
+            case PickStage::BadCaptures:
+                while (captureIdx < captures.size()) {
+                    pickBest(captures, captureScores, captureIdx, captures.size());
+                    Move m = captures[captureIdx++];
+                    if (m != ttMove)
+                        return m;
+                }
+                stage = PickStage::Done;
+                return NullMove;
+
+            case PickStage::QCaptures:
+                if (captureIdx < captures.size()) {
+                    pickBest(captures, captureScores, captureIdx, captures.size());
+                    return captures[captureIdx++];
+                }
+                stage = PickStage::Done;
+                return NullMove;
+
+            case PickStage::Done:
+                return NullMove;
+        }
+        return NullMove;
+    }
+
+   private:
+    // Scores captures and moves the losing ones (SEE < 0) behind `goodEnd`.
+    void scoreCaptures() {
+        goodEnd = captures.size();
+        for (int i = 0; i < goodEnd;) {
+            int see = staticExchangeEval(board, captures[i]);
+            captureScores[i] = captureScore(board, captures[i], see);
+            if (see < 0) {
+                --goodEnd;
+                std::swap(captures.moves[i], captures.moves[goodEnd]);
+                std::swap(captureScores[i], captureScores[goodEnd]);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    const Board& board;
+    const SearchState* state;
+    Move ttMove;
+    Move killers[2] = {NullMove, NullMove};
+    PickStage stage;
+
+    MoveList captures;
+    MoveList quiets;
+    int captureScores[256];
+    int quietScores[256];
+    int captureIdx = 0;
+    int goodEnd = 0;
+    int killerIdx = 0;
+    int quietIdx = 0;
+};
+
 // ============================================================
 // Quiescence search
 // ============================================================
@@ -347,9 +623,8 @@ static int quiescence(Board& board, int alpha, int beta, SearchState& state, int
         return 0;
     if (state.checkTime())
         return 0;
-    ++state.nodes;
-    if (state.sharedNodes)
-        state.sharedNodes->fetch_add(1, std::memory_order_relaxed);
+    state.nodes->increment();
+    state.stats.add(SearchStat::QNodes);
 
     if (isThreefoldRepetition(board, state, repIndex))
         return 0;
@@ -360,45 +635,32 @@ static int quiescence(Board& board, int alpha, int beta, SearchState& state, int
     int standPat = 0;
     bool inCheck = in_check(board);
     bool pvNode = (beta - alpha > 1);
-    MoveList allMoves = generate_legal(board);
     MoveList qmoves;
 
     if (inCheck) {
-        qmoves = allMoves;
+        qmoves = generate_legal(board, GenType::Evasions);
+        if (qmoves.size() == 0)
+            return -MATE_SCORE + ply;  // Checkmate: lose in 'ply' half-moves
     } else {
-        // True stalemate: no legal moves at all and not in check
-        if (allMoves.size() == 0)
-            return 0;
-
-        // Stand pat only if not in check
-        standPat = evaluate(board, &state.nnueCtx);
+        // Stand pat only if not in check. A stand-pat cutoff never generates moves.
+        standPat = staticEvaluate(board, state);
 
         if (standPat >= beta)
             return beta;
         if (standPat > alpha)
             alpha = standPat;
 
-        for (int i = 0; i < allMoves.size(); ++i) {
-            if (isCapture(board, allMoves[i]))
-                qmoves.add(allMoves[i]);
-        }
-    }
+        qmoves = generate_legal(board, GenType::Captures);
 
-    // Check for checkmate (in check with no legal moves) or no captures
-    if (qmoves.size() == 0) {
-        if (inCheck)
-            return -MATE_SCORE + ply;  // Checkmate: lose in 'ply' half-moves
-        return alpha;                  // No captures; stand pat
+        // No captures or promotions: stand pat, unless this is a true stalemate
+        if (qmoves.size() == 0)
+            return has_legal_moves(board) ? alpha : 0;
     }
 
-    // MVV-LVA ordering for captures
-    int scores[256];
-    scoreCapturesMvvLva(board, qmoves, scores);
-
-    for (int i = 0; i < qmoves.size(); ++i) {
-        pickBest(qmoves, scores, i);
-        Move m = qmoves[i];
+    // SEE + MVV-LVA ordering for captures and promotions
+    MovePicker picker(board, qmoves);
 
+    for (Move m = picker.next(); m != NullMove; m = picker.next()) {
         // Delta pruning: skip if the capture + margin can't possibly raise alpha
         // Only apply when not in check and we have a valid standPat
         if (!inCheck) {
@@ -493,13 +755,12 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
     if (state.stopped)
         return 0;
 
-    // Periodically check time (every node is fine for now)
+    // Periodically check time
     if (state.checkTime())
         return 0;
 
-    ++state.nodes;
-    if (state.sharedNodes)
-        state.sharedNodes->fetch_add(1, std::memory_order_relaxed);
+    state.nodes->increment();
+    state.stats.add(SearchStat::Nodes);
 
     if (isThreefoldRepetition(board, state, repIndex))
         return 0;
@@ -513,19 +774,19 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
     // TT probe
     TTEntry ttEntry;
     Move ttMove = NullMove;
-    if (state.tt.probe(board.hash_key(), ttEntry)) {
+    state.stats.add(SearchStat::TTProbes);
+    if (state.tt->probe(board.hash_key(), ttEntry)) {
+        state.stats.add(SearchStat::TTHits);
         ttMove = ttEntry.bestMove;
         if (ttEntry.depth >= depth) {
             int ttScore = scoreFromTT(ttEntry.score, ply);
             // In PV nodes, only allow exact cutoffs to preserve the principal variation.
             // In non-PV nodes, allow all cutoff types.
-            if (ttEntry.flag == TT_EXACT)
+            if (ttEntry.flag == TT_EXACT ||
+                (!pvNode && ttEntry.flag == TT_BETA && ttScore >= beta) ||
+                (!pvNode && ttEntry.flag == TT_ALPHA && ttScore <= alpha)) {
+                state.stats.add(SearchStat::TTCutoffs);
                 return ttScore;
-            if (!pvNode) {
-                if (ttEntry.flag == TT_BETA && ttScore >= beta)
-                    return ttScore;
-                if (ttEntry.flag == TT_ALPHA && ttScore <= alpha)
-                    return ttScore;
             }
         }
     }
@@ -534,29 +795,22 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
     if (depth == 0)
         return quiescence(board, alpha, beta, state, ply, repIndex);
 
-    MoveList moves = generate_legal(board);
-
-    // Terminal node detection
-    if (moves.size() == 0) {
-        if (in_check(board))
-            return -MATE_SCORE + ply;  // Checkmate
-        return 0;                      // Stalemate
-    }
-
     bool inCheck = in_check(board);
-    int staticEval = evaluate(board, &state.nnueCtx);
+    int staticEval = staticEvaluate(board, state);
 
     // Reverse futility pruning (static null move pruning)
     // If our position is so good that even after a margin we still beat beta, prune.
     // Skip in PV nodes to preserve exact scores on the principal variation.
     if (!pvNode && !inCheck && depth <= FUTILITY_MAX_DEPTH &&
         std::abs(beta) < MATE_SCORE - MAX_PLY && staticEval - RFP_MARGIN[depth] >= beta) {
+        state.stats.add(SearchStat::RfpPrunes);
         return staticEval - RFP_MARGIN[depth];
     }
 
     // Null move pruning
     if (allowNullMove && !inCheck && depth >= NMP_MIN_DEPTH &&
         nonPawnMaterial(board, board.side_to_move()) >= NMP_MIN_MATERIAL) {
+        state.stats.add(SearchStat::NmpTries);
         Board::UndoInfo nullUndo;
         board.make_null_move(nullUndo);
         state.nnueCtx.on_null_move(board);
@@ -587,24 +841,27 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
                     negamax(board, depth - 1, beta - 1, beta, state, ply, repIndex, false);
                 if (state.stopped)
                     return 0;
-                if (verifyScore >= beta)
+                if (verifyScore >= beta) {
+                    state.stats.add(SearchStat::NmpCutoffs);
                     return beta;
+                }
             } else {
+                state.stats.add(SearchStat::NmpCutoffs);
                 return beta;
             }
         }
     }
 
-    // Score and order moves
-    int scores[256];
-    scoreMoves(board, moves, scores, ttMove, state, ply);
+    // Moves are generated and scored stage by stage as the picker reaches them
+    MovePicker picker(board, ttMove, state, ply);
 
-    Move bestMove = moves[0];
+    Move bestMove = NullMove;
     TTFlag flag = TT_ALPHA;
+    int i = 0;  // index of the current move in search order
 
-    for (int i = 0; i < moves.size(); ++i) {
-        pickBest(moves, scores, i);
-        Move m = moves[i];
+    for (Move m = picker.next(); m != NullMove; m = picker.next(), ++i) {
+        if (i == 0)
+            bestMove = m;
         bool capture = isCapture(board, m);
         bool isPromotion = move_type(m) == Promotion;
 
@@ -613,9 +870,13 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
             i > 0  // never prune the first move (ensures we have a legal move)
             && !capture && !isPromotion && std::abs(alpha) < MATE_SCORE - MAX_PLY &&
             staticEval + FUTILITY_MARGIN[depth] <= alpha) {
+            state.stats.add(SearchStat::FutilityPrunes);
             continue;
         }
 
+        // The child probes the TT first; overlap that fetch with make_move and NNUE work
+        state.tt->prefetch(board.key_after(m));
+
         Board::UndoInfo undo;
         board.make_move(m, undo);
         state.nnueCtx.on_make_move(board, m, undo.nnueDirtyPiece, undo.nnueDirtyThreats);
@@ -632,6 +893,7 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
                      !isPromotion;
 
         if (doLMR) {
+            state.stats.add(SearchStat::LmrSearches);
             // LMR: reduced-depth zero-window search
             int d = depth - 1;
             int mi = (i < 64) ? i : 63;
@@ -648,6 +910,7 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
             // Re-search at full depth with zero window if scout search reaches alpha.
             // Use >= with fail-hard returns.
             if (!state.stopped && score >= alpha) {
+                state.stats.add(SearchStat::LmrResearches);
                 score =
                     -negamax(board, depth - 1, -alpha - 1, -alpha, state, ply + 1, childRepIndex);
             }
@@ -663,6 +926,7 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
         // PVS full-window re-search when scout search reaches alpha.
         // Use >= with fail-hard returns.
         if (!state.stopped && i > 0 && score >= alpha && score < beta) {
+            state.stats.add(SearchStat::PvsResearches);
             score = -negamax(board, depth - 1, -beta, -alpha, state, ply + 1, childRepIndex);
         }
         board.unmake_move(m, undo);
@@ -672,7 +936,10 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
             return 0;
 
         if (score >= beta) {
-            state.tt.store(board.hash_key(), scoreToTT(score, ply), depth, TT_BETA, m);
+            state.stats.add(SearchStat::BetaCutoffs);
+            if (i == 0)
+                state.stats.add(SearchStat::FirstMoveCutoffs);
+            state.tt->store(board.hash_key(), scoreToTT(score, ply), depth, TT_BETA, m);
 
             // Update killer moves and history for quiet moves
             if (!capture) {
@@ -692,7 +959,11 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
         }
     }
 
-    state.tt.store(board.hash_key(), scoreToTT(alpha, ply), depth, flag, bestMove);
+    // Terminal node detection: the first move is never pruned, so no move means none exist
+    if (i == 0)
+        return inCheck ? -MATE_SCORE + ply : 0;
+
+    state.tt->store(board.hash_key(), scoreToTT(alpha, ply), depth, flag, bestMove);
     return alpha;
 }
 
@@ -702,32 +973,34 @@ static int negamax(Board& board, int depth, int alpha, int beta, SearchState& st
 
 static SearchResult searchRoot(Board& board, int depth, int alpha, int beta, SearchState& state) {
     const int origAlpha = alpha;
-    MoveList moves = generate_legal(board);
 
-    if (moves.size() == 0) {
+    // TT move ordering at root
+    TTEntry ttEntry;
+    Move ttMove = NullMove;
+    if (state.tt->probe(board.hash_key(), ttEntry))
+        ttMove = ttEntry.bestMove;
+
+    // The picker's first move doubles as the terminal check, so the root generates only once
+    MovePicker picker(board, ttMove, state, 0);
+    Move m = picker.next();
+
+    if (m == NullMove) {
         if (in_check(board))
             return {NullMove, -MATE_SCORE};  // side to move is checkmated at root (ply 0)
         return {NullMove, 0};                // stalemate
     }
 
     if (isThreefoldRepetition(board, state, state.rootRepIndex))
-        return {moves[0], 0};
-
-    // TT move ordering at root
-    TTEntry ttEntry;
-    Move ttMove = NullMove;
-    if (state.tt.probe(board.hash_key(), ttEntry))
-        ttMove = ttEntry.bestMove;
+        return {m, 0};
 
-    int scores[256];
-    scoreMoves(board, moves, scores, ttMove, state, 0);
-
-    Move bestMove = moves[0];
+    Move bestMove = m;
     int bestScore = -MATE_SCORE - 1;
+    const uint64_t rootStartNodes = state.nodes->load();
+    state.rootBestMoveNodes = 0;
 
-    for (int i = 0; i < moves.size(); ++i) {
-        pickBest(moves, scores, i);
-        Move m = moves[i];
+    for (; m != NullMove; m = picker.next()) {
+        const uint64_t moveStartNodes = state.nodes->load();
+        state.tt->prefetch(board.key_after(m));
 
         Board::UndoInfo undo;
         board.make_move(m, undo);
@@ -748,6 +1021,7 @@ static SearchResult searchRoot(Board& board, int depth, int alpha, int beta, Sea
         if (score > bestScore) {
             bestScore = score;
             bestMove = m;
+            state.rootBestMoveNodes = state.nodes->load() - moveStartNodes;
         }
         if (score > alpha)
             alpha = score;
@@ -756,6 +1030,8 @@ static SearchResult searchRoot(Board& board, int depth, int alpha, int beta, Sea
             break;
     }
 
+    state.rootNodes = state.nodes->load() - rootStartNodes;
+
     if (!state.stopped) {
         // Determine correct TT flag based on window bounds
         TTFlag flag;
@@ -766,12 +1042,206 @@ static SearchResult searchRoot(Board& board, int depth, int alpha, int beta, Sea
         else
             flag = TT_EXACT;  // Within window: exact score
 
-        state.tt.store(board.hash_key(), scoreToTT(bestScore, 0), depth, flag, bestMove);
+        state.tt->store(board.hash_key(), scoreToTT(bestScore, 0), depth, flag, bestMove);
     }
 
     return {bestMove, bestScore};
 }
 
+// Searches `depth` in a window around the previous iteration's score, widening the side that
+// failed until the score lands inside it.
+static SearchResult aspirationSearch(Board& root, int depth, int previousScore,
+                                     SearchState& state) {
+    int delta = ASPIRATION_WINDOW;
+    int alpha = previousScore - delta;
+    int beta = previousScore + delta;
+
+    while (true) {
+        SearchResult result = searchRoot(root, depth, alpha, beta, state);
+        if (state.stopped)
+            return result;
+
+        if (result.score <= alpha) {
+            // Fail low: widen alpha
+            state.stats.add(SearchStat::AspirationFailLows);
+            alpha = (alpha - delta > -MATE_SCORE - 1) ? alpha - delta : -MATE_SCORE - 1;
+            delta *= 2;
+        } else if (result.score >= beta) {
+            // Fail high: widen beta
+            state.stats.add(SearchStat::AspirationFailHighs);
+            beta = (beta + delta < MATE_SCORE + 1) ? beta + delta : MATE_SCORE + 1;
+            delta *= 2;
+        } else {
+            return result;  // Score within window
+        }
+    }
+}
+
+// ============================================================
+// Search thread pool
+// ============================================================
+
+// Search states and helper threads of the threaded search, kept between searches. State 0
+// belongs to whichever thread calls search(); helpers 1..N-1 park on a condition variable
+// and are woken with a job for each search. Keeping the states means a search does not pay
+// for NNUE accumulator stacks, refresh caches or eval caches again.
+class SearchThreadPool {
+   public:
+    int size() const {
+        return static_cast<int>(states.size());
+    }
+
+    // The state of thread `id`, prepared for a new search on `tt`
+    SearchState& attach(int id, TranspositionTable& tt, std::atomic<bool>* stop,
+                        NodeCounter* counter) {
+        if (!states[id])
+            states[id] = std::make_unique<SearchState>(tt, stop, counter);
+        else
+            states[id]->attach(tt, stop, counter);
+        return *states[id];
+    }
+
+    void clearHeuristics() {
+        for (auto& state : states) {
+            if (state)
+                state->clearHeuristics();
+        }
+    }
+
+    // Threads are only added or removed here, never while a job runs
+    void resize(int threadCount) {
+        if (threadCount == size())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : helpers) t.join();
+        helpers.clear();
+        quit = false;
+
+        // Surviving states keep their allocations; new ones are created on their first search
+        states.resize(threadCount);
+        for (int id = 1; id < threadCount; ++id)
+            helpers.emplace_back([this, id, seen = generation]() { idle(id, seen); });
+    }
+
+    // Runs job(id) on every helper and returns at once; wait() blocks until all are done
+    void start(std::function<void(int)> helperJob) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = std::move(helperJob);
+            running = size() - 1;
+            ++generation;
+        }
+        wake.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return running == 0; });
+    }
+
+    // Held by search() throughout, so concurrent searches run one after another
+    std::mutex searchMutex;
+
+   private:
+    void idle(int id, uint64_t seen) {
+        while (true) {
+            std::function<void(int)> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return quit || generation != seen; });
+                if (quit)
+                    return;
+                seen = generation;
+                task = job;
+            }
+
+            task(id);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--running == 0)
+                done.notify_all();
+        }
+    }
+
+    std::vector<std::unique_ptr<SearchState>> states;
+    std::vector<std::thread> helpers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void(int)> job;
+    uint64_t generation = 0;
+    int running = 0;
+    bool quit = false;
+};
+
+// Never destroyed: the states hold NNUE caches borrowed from the backend, which may already
+// be gone during static destruction. Parked helpers simply end with the process.
+static SearchThreadPool& threadPool() {
+    static SearchThreadPool* pool = new SearchThreadPool();
+    return *pool;
+}
+
+// ============================================================
+// Lazy SMP result voting
+// ============================================================
+
+// Last iteration a search thread completed. Written by its thread, read by the main thread
+// for info output and the final vote.
+struct ThreadResult {
+    int depth = 0;
+    SearchResult result = {NullMove, 0};
+};
+
+static bool isWinningMate(int score) {
+    return score > MATE_SCORE - MAX_PLY;
+}
+
+// Picks the move to play from every thread's last completed iteration. Each thread votes for
+// its move with a weight that grows with its depth and with how far its score is above the
+// worst one, so a move found by several threads, or by a thread that got deeper, beats the
+// main thread's alone. A proven mate overrides the vote; the fastest one wins.
+static int voteBestThread(const std::vector<ThreadResult>& threads) {
+    int minScore = MATE_SCORE;
+    for (const ThreadResult& t : threads) {
+        if (t.depth > 0)
+            minScore = std::min(minScore, t.result.score);
+    }
+
+    auto votesFor = [&](Move m) {
+        int64_t votes = 0;
+        for (const ThreadResult& t : threads) {
+            if (t.depth > 0 && t.result.bestMove == m)
+                votes += int64_t(t.result.score - minScore + 14) * t.depth;
+        }
+        return votes;
+    };
+
+    int best = 0;
+    for (int i = 1; i < static_cast<int>(threads.size()); ++i) {
+        const ThreadResult& t = threads[i];
+        const ThreadResult& b = threads[best];
+        if (t.depth == 0 || t.result.bestMove == NullMove)
+            continue;
+        if (b.depth == 0 || b.result.bestMove == NullMove) {
+            best = i;
+        } else if (isWinningMate(b.result.score) || isWinningMate(t.result.score)) {
+            if (t.result.score > b.result.score)
+                best = i;
+        } else {
+            int64_t tVotes = votesFor(t.result.bestMove);
+            int64_t bVotes = votesFor(b.result.bestMove);
+            if (tVotes > bVotes || (tVotes == bVotes && t.depth > b.depth))
+                best = i;
+        }
+    }
+    return best;
+}
+
 // ============================================================
 // Public API
 // ============================================================
@@ -794,28 +1264,7 @@ SearchResult search(const Board& board, int timeLimitMs, TranspositionTable& tt)
             // First iteration: full window
             result = searchRoot(root, depth, -MATE_SCORE - 1, MATE_SCORE + 1, state);
         } else {
-            // Aspiration window around previous score
-            int delta = ASPIRATION_WINDOW;
-            int alpha = bestResult.score - delta;
-            int beta = bestResult.score + delta;
-
-            while (true) {
-                result = searchRoot(root, depth, alpha, beta, state);
-                if (state.stopped)
-                    break;
-
-                if (result.score <= alpha) {
-                    // Fail low: widen alpha
-                    alpha = (alpha - delta > -MATE_SCORE - 1) ? alpha - delta : -MATE_SCORE - 1;
-                    delta *= 2;
-                } else if (result.score >= beta) {
-                    // Fail high: widen beta
-                    beta = (beta + delta < MATE_SCORE + 1) ? beta + delta : MATE_SCORE + 1;
-                    delta *= 2;
-                } else {
-                    break;  // Score within window
-                }
-            }
+            result = aspirationSearch(root, depth, bestResult.score, state);
         }
 
         if (state.stopped) {
@@ -856,16 +1305,8 @@ std::vector<Move> extractPV(const Board& board, TranspositionTable& tt, int maxL
         TTEntry entry;
         if (!tt.probe(b.hash_key(), entry) || entry.bestMove == NullMove)
             break;
-        // Verify the move is legal
-        MoveList legal = generate_legal(b);
-        bool found = false;
-        for (int j = 0; j < legal.size(); ++j) {
-            if (legal[j] == entry.bestMove) {
-                found = true;
-                break;
-            }
-        }
-        if (!found)
+        // The 16-bit key check can match a different position
+        if (!is_legal(b, entry.bestMove))
             break;
         pv.push_back(entry.bestMove);
         b.make_move(entry.bestMove);
@@ -881,113 +1322,129 @@ SearchResult search(const Board& board, int timeLimitMs, int maxDepth, Transposi
 SearchResult search(const Board& board, int timeLimitMs, int maxDepth, TranspositionTable& tt,
                     std::atomic<bool>& stopFlag, const std::vector<uint64_t>& repetitionHistory,
                     InfoCallback infoCallback) {
-    tt.new_search();
-    SearchState state(tt, &stopFlag);
-    state.startTime = std::chrono::steady_clock::now();
-    state.timeLimitMs = timeLimitMs;
-    initRepetitionHistory(state, board, repetitionHistory);
-    Board root = board;
-    state.nnueCtx.reset(root);
+    return search(board, timeLimitMs, maxDepth, tt, stopFlag, repetitionHistory, 1, infoCallback);
+}
 
-    SearchResult bestResult = {NullMove, 0};
+SearchResult search(const Board& board, int timeLimitMs, int maxDepth, TranspositionTable& tt,
+                    std::atomic<bool>& stopFlag, const std::vector<uint64_t>& repetitionHistory,
+                    int numThreads, InfoCallback infoCallback) {
+    TimeLimits limits{timeLimitMs, timeLimitMs, true};
+    return search(board, limits, maxDepth, tt, stopFlag, repetitionHistory, numThreads,
+                  infoCallback);
+}
 
-    if (maxDepth < 1)
-        maxDepth = MAX_PLY;
+void set_search_threads(int numThreads) {
+    SearchThreadPool& pool = threadPool();
+    std::lock_guard<std::mutex> searchLock(pool.searchMutex);
+    pool.resize(std::max(numThreads, 1));
+}
 
-    for (int depth = 1; depth <= maxDepth; ++depth) {
-        SearchResult result;
+int search_threads() {
+    SearchThreadPool& pool = threadPool();
+    std::lock_guard<std::mutex> searchLock(pool.searchMutex);
+    return pool.size();
+}
 
-        if (depth <= 1) {
-            result = searchRoot(root, depth, -MATE_SCORE - 1, MATE_SCORE + 1, state);
-        } else {
-            int delta = ASPIRATION_WINDOW;
-            int alpha = bestResult.score - delta;
-            int beta = bestResult.score + delta;
+void clear_search_heuristics() {
+    SearchThreadPool& pool = threadPool();
+    std::lock_guard<std::mutex> searchLock(pool.searchMutex);
+    pool.clearHeuristics();
+}
 
-            while (true) {
-                result = searchRoot(root, depth, alpha, beta, state);
-                if (state.stopped)
-                    break;
-
-                if (result.score <= alpha) {
-                    alpha = (alpha - delta > -MATE_SCORE - 1) ? alpha - delta : -MATE_SCORE - 1;
-                    delta *= 2;
-                } else if (result.score >= beta) {
-                    beta = (beta + delta < MATE_SCORE + 1) ? beta + delta : MATE_SCORE + 1;
-                    delta *= 2;
-                } else {
-                    break;
-                }
-            }
-        }
+SearchResult search(const Board& board, const TimeLimits& limits, int maxDepth,
+                    TranspositionTable& tt, std::atomic<bool>& stopFlag,
+                    const std::vector<uint64_t>& repetitionHistory, int numThreads,
+                    InfoCallback infoCallback) {
+    if (numThreads < 1)
+        numThreads = 1;
 
-        if (state.stopped) {
-            // Keep a legal root move even when stopped during depth 1.
-            if (depth == 1 && result.bestMove != NullMove)
-                bestResult = result;
-            break;
-        }
-        bestResult = result;
+    SearchThreadPool& pool = threadPool();
+    std::lock_guard<std::mutex> searchLock(pool.searchMutex);
+    pool.resize(numThreads);
 
-        // Send info callback
-        if (infoCallback) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed =
-                std::chrono::duration_cast<std::chrono::milliseconds>(now - state.startTime)
-                    .count();
-
-            SearchInfo info;
-            info.depth = depth;
-            info.score = bestResult.score;
-            info.nodes = state.nodes;
-            info.timeMs = elapsed;
-            info.pv = extractPV(board, tt, depth);
-
-            // Determine if this is a mate score
-            if (bestResult.score > MATE_SCORE - MAX_PLY) {
-                info.isMate = true;
-                info.mateInPly = (MATE_SCORE - bestResult.score + 1) / 2;
-            } else if (bestResult.score < -MATE_SCORE + MAX_PLY) {
-                info.isMate = true;
-                info.mateInPly = -((MATE_SCORE + bestResult.score + 1) / 2);
-            } else {
-                info.isMate = false;
-                info.mateInPly = 0;
-            }
+    tt.new_search();
+    TimeManager timeManager(limits);
+
+    // One padded counter per thread; the main thread sums them when it reports.
+    std::vector<NodeCounter> nodeCounters(numThreads);
+    auto totalNodes = [&nodeCounters]() {
+        uint64_t sum = 0;
+        for (const NodeCounter& counter : nodeCounters) sum += counter.load();
+        return sum;
+    };
+    auto startTime = std::chrono::steady_clock::now();
 
-            infoCallback(info);
+    // Last completed iteration of every thread, published once per iteration
+    std::vector<ThreadResult> threadResults(numThreads);
+    std::mutex threadResultsMutex;
+    auto publish = [&](int threadId, int depth, const SearchResult& result) {
+        std::lock_guard<std::mutex> lock(threadResultsMutex);
+        threadResults[threadId] = {depth, result};
+    };
+    // The deepest iteration any thread has completed, the main thread's on a tie
+    auto deepestResult = [&]() {
+        std::lock_guard<std::mutex> lock(threadResultsMutex);
+        ThreadResult deepest = threadResults[0];
+        for (const ThreadResult& t : threadResults) {
+            if (t.depth > deepest.depth)
+                deepest = t;
         }
+        return deepest;
+    };
 
-        if (bestResult.score > MATE_SCORE - MAX_PLY || bestResult.score < -MATE_SCORE + MAX_PLY)
-            break;
-    }
-
-    return bestResult;
-}
+    // The PV is rebuilt from the TT behind the reported move: the root entry itself may
+    // already hold another thread's move.
+    auto pvFor = [&](const SearchResult& result, int depth) {
+        std::vector<Move> pv;
+        if (result.bestMove == NullMove)
+            return pv;
+        pv.push_back(result.bestMove);
+        Board afterBest = board;
+        afterBest.make_move(result.bestMove);
+        for (Move m : extractPV(afterBest, tt, depth - 1)) pv.push_back(m);
+        return pv;
+    };
 
-SearchResult search(const Board& board, int timeLimitMs, int maxDepth, TranspositionTable& tt,
-                    std::atomic<bool>& stopFlag, const std::vector<uint64_t>& repetitionHistory,
-                    int numThreads, InfoCallback infoCallback) {
-    if (numThreads <= 1) {
-        return search(board, timeLimitMs, maxDepth, tt, stopFlag, repetitionHistory, infoCallback);
-    }
+    auto sendInfo = [&](int depth, const SearchResult& result, std::vector<Move> pv) {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
 
-    tt.new_search();
+        SearchInfo info;
+        info.depth = depth;
+        info.score = result.score;
+        info.nodes = totalNodes();
+        info.timeMs = elapsed;
+        info.pv = std::move(pv);
+
+        if (result.score > MATE_SCORE - MAX_PLY) {
+            info.isMate = true;
+            info.mateInPly = (MATE_SCORE - result.score + 1) / 2;
+        } else if (result.score < -MATE_SCORE + MAX_PLY) {
+            info.isMate = true;
+            info.mateInPly = -((MATE_SCORE + result.score + 1) / 2);
+        } else {
+            info.isMate = false;
+            info.mateInPly = 0;
+        }
 
-    std::atomic<uint64_t> totalNodes{0};
-    auto startTime = std::chrono::steady_clock::now();
+        infoCallback(info);
+    };
 
-    // Helper thread worker: runs iterative deepening with a depth offset for diversification.
-    // Uses the shared TT and stopFlag but has its own SearchState.
+    // Helper thread worker: iterative deepening with aspiration windows around its own
+    // previous score, at a depth offset for diversification. Uses the shared TT and stopFlag
+    // but has its own SearchState; its completed iterations take part in the final vote.
     auto workerFunc = [&](int threadId) {
-        SearchState state(tt, &stopFlag, &totalNodes);
+        SearchState& state = pool.attach(threadId, tt, &stopFlag, &nodeCounters[threadId]);
         state.startTime = startTime;
-        state.timeLimitMs = timeLimitMs;
+        state.timeLimitMs = 0;  // the main thread owns the deadline and raises stopFlag
         initRepetitionHistory(state, board, repetitionHistory);
         Board root = board;
         state.nnueCtx.reset(root);
 
         int workerMaxDepth = (maxDepth < 1) ? MAX_PLY : maxDepth;
+        int completedDepth = 0;
+        SearchResult previous = {NullMove, 0};
 
         for (int depth = 1; depth <= workerMaxDepth; ++depth) {
             // Depth diversification: even threads search deeper, odd threads shallower
@@ -1005,24 +1462,31 @@ SearchResult search(const Board& board, int timeLimitMs, int maxDepth, Transposi
             if (state.stopped || stopFlag.load(std::memory_order_relaxed))
                 break;
 
-            searchRoot(root, adjustedDepth, -MATE_SCORE - 1, MATE_SCORE + 1, state);
+            SearchResult result;
+            if (completedDepth == 0) {
+                result = searchRoot(root, adjustedDepth, -MATE_SCORE - 1, MATE_SCORE + 1, state);
+            } else {
+                result = aspirationSearch(root, adjustedDepth, previous.score, state);
+            }
 
             if (state.stopped)
                 break;
+
+            previous = result;
+            completedDepth = adjustedDepth;
+            publish(threadId, completedDepth, result);
         }
+        state.mergeStats();
     };
 
-    // Launch helper threads (threads 1..N-1)
-    std::vector<std::thread> helpers;
-    helpers.reserve(numThreads - 1);
-    for (int i = 1; i < numThreads; ++i) {
-        helpers.emplace_back(workerFunc, i);
-    }
+    // Wake the parked helpers (threads 1..N-1)
+    if (numThreads > 1)
+        pool.start(workerFunc);
 
     // Main thread (thread 0): runs normal iterative deepening with aspiration windows
-    SearchState mainState(tt, &stopFlag, &totalNodes);
+    SearchState& mainState = pool.attach(0, tt, &stopFlag, &nodeCounters[0]);
     mainState.startTime = startTime;
-    mainState.timeLimitMs = timeLimitMs;
+    mainState.timeLimitMs = limits.maximumMs;
     initRepetitionHistory(mainState, board, repetitionHistory);
     Board root = board;
     mainState.nnueCtx.reset(root);
@@ -1036,72 +1500,53 @@ SearchResult search(const Board& board, int timeLimitMs, int maxDepth, Transposi
         if (depth <= 1) {
             result = searchRoot(root, depth, -MATE_SCORE - 1, MATE_SCORE + 1, mainState);
         } else {
-            int delta = ASPIRATION_WINDOW;
-            int alpha = bestResult.score - delta;
-            int beta = bestResult.score + delta;
-
-            while (true) {
-                result = searchRoot(root, depth, alpha, beta, mainState);
-                if (mainState.stopped)
-                    break;
-
-                if (result.score <= alpha) {
-                    alpha = (alpha - delta > -MATE_SCORE - 1) ? alpha - delta : -MATE_SCORE - 1;
-                    delta *= 2;
-                } else if (result.score >= beta) {
-                    beta = (beta + delta < MATE_SCORE + 1) ? beta + delta : MATE_SCORE + 1;
-                    delta *= 2;
-                } else {
-                    break;
-                }
-            }
+            result = aspirationSearch(root, depth, bestResult.score, mainState);
         }
 
         if (mainState.stopped) {
-            if (depth == 1 && result.bestMove != NullMove)
+            // Keep a legal move if we were stopped during the first iteration
+            if (depth == 1 && result.bestMove != NullMove) {
                 bestResult = result;
+                publish(0, 1, result);
+            }
             break;
         }
         bestResult = result;
+        publish(0, depth, result);
 
+        // Report the deepest iteration any thread has completed, with that iteration's own
+        // score and PV, so depth, score and line always belong together
         if (infoCallback) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed =
-                std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime).count();
-
-            SearchInfo info;
-            info.depth = depth;
-            info.score = bestResult.score;
-            info.nodes = totalNodes.load(std::memory_order_relaxed);
-            info.timeMs = elapsed;
-            info.pv = extractPV(board, tt, depth);
-
-            if (bestResult.score > MATE_SCORE - MAX_PLY) {
-                info.isMate = true;
-                info.mateInPly = (MATE_SCORE - bestResult.score + 1) / 2;
-            } else if (bestResult.score < -MATE_SCORE + MAX_PLY) {
-                info.isMate = true;
-                info.mateInPly = -((MATE_SCORE + bestResult.score + 1) / 2);
-            } else {
-                info.isMate = false;
-                info.mateInPly = 0;
-            }
-
-            infoCallback(info);
+            ThreadResult deepest = deepestResult();
+            sendInfo(deepest.depth, deepest.result, pvFor(deepest.result, deepest.depth));
         }
 
         if (bestResult.score > MATE_SCORE - MAX_PLY || bestResult.score < -MATE_SCORE + MAX_PLY)
             break;
+
+        IterationReport report{depth, bestResult.bestMove, bestResult.score,
+                               mainState.rootBestMoveNodes, mainState.rootNodes};
+        if (timeManager.stop_after_iteration(report))
+            break;
     }
 
-    // Stop helpers and wait for them
+    mainState.mergeStats();
+    if (numThreads == 1)
+        return bestResult;
+
+    // Stop helpers and wait for them to park again
     stopFlag.store(true, std::memory_order_relaxed);
-    for (auto& t : helpers) {
-        if (t.joinable())
-            t.join();
-    }
+    pool.wait();
 
-    return bestResult;
+    // The helpers are parked, so their results can be read without the lock
+    const ThreadResult& voted = threadResults[voteBestThread(threadResults)];
+    if (voted.depth == 0 || voted.result.bestMove == bestResult.bestMove)
+        return bestResult;
+
+    // A helper's move won: report its iteration, whose line starts with that move
+    if (infoCallback)
+        sendInfo(voted.depth, voted.result, pvFor(voted.result, voted.depth));
+    return voted.result;
 }
 
 int quiescenceForTests(const Board& board, int alpha, int beta,
@@ -1117,4 +1562,8 @@ int quiescenceForTests(const Board& board, int alpha, int beta,
     return quiescence(copy, alpha, beta, state, 0, state.rootRepIndex);
 }
 
+int staticExchangeEvalForTests(const Board& board, Move m) {
+    return staticExchangeEval(board, m);
+}
+
 }  // namespace panda
@@ -7,11 +7,12 @@
 
 #include "board.h"
 #include "move.h"
+#include "timeman.h"
 #include "tt.h"
 
 namespace panda {
 
-constexpr int MATE_SCORE = 100000;
+constexpr int MATE_SCORE = 32000;  // fits the 16-bit TT score field with MAX_PLY headroom
 constexpr int MAX_PLY = 64;
 
 struct SearchResult {
@@ -53,6 +54,25 @@ SearchResult search(const Board& board, int timeLimitMs, int maxDepth, Transposi
                     std::atomic<bool>& stopFlag, const std::vector<uint64_t>& repetitionHistory,
                     int numThreads, InfoCallback infoCallback = nullptr);
 
+// UCI search with adaptive time management: stops between iterations once the (scaled)
+// optimum is used up or the next iteration could not finish, and never runs past the
+// maximum. The overloads above use a fixed budget of `timeLimitMs`.
+SearchResult search(const Board& board, const TimeLimits& limits, int maxDepth,
+                    TranspositionTable& tt, std::atomic<bool>& stopFlag,
+                    const std::vector<uint64_t>& repetitionHistory, int numThreads,
+                    InfoCallback infoCallback = nullptr);
+
+// Sizes the pool of search threads. Helpers are started here and parked between searches,
+// keeping their per-thread state; search() only resizes the pool when given another count.
+void set_search_threads(int numThreads);
+
+// Threads in the pool, as last sized by set_search_threads() or search()
+int search_threads();
+
+// Move-ordering history and eval caches persist between searches, aged at the start of each;
+// this clears them, as for "ucinewgame".
+void clear_search_heuristics();
+
 // Extract principal variation from transposition table
 std::vector<Move> extractPV(const Board& board, TranspositionTable& tt, int maxLen);
 
@@ -61,4 +81,7 @@ std::vector<Move> extractPV(const Board& board, TranspositionTable& tt, int maxL
 int quiescenceForTests(const Board& board, int alpha, int beta,
                        const std::vector<uint64_t>& repetitionHistory = {});
 
+// Test and microbenchmark helper: static exchange evaluation of `m`, in centipawns.
+int staticExchangeEvalForTests(const Board& board, Move m);
+
 }  // namespace panda
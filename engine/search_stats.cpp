@@ -0,0 +1,72 @@
+#include "search_stats.h"
+
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+
+namespace panda {
+
+static std::mutex totalsMutex;
+static SearchStats totals;
+
+void SearchStats::merge(const SearchStats& other) {
+    for (int i = 0; i < int(SearchStat::Count); ++i) counts[i] += other.counts[i];
+}
+
+void merge_search_stats(const SearchStats& stats) {
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    totals.merge(stats);
+}
+
+SearchStats search_stats_totals() {
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    return totals;
+}
+
+void reset_search_stats() {
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    totals = SearchStats{};
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * double(part) / double(whole) : 0.0;
+}
+
+void print_search_stats(const SearchStats& s, std::ostream& out, const char* prefix) {
+    if (!SEARCH_STATS_ENABLED) {
+        out << prefix << "search stats are disabled; configure with -DPANDA_SEARCH_STATS=ON"
+            << std::endl;
+        return;
+    }
+
+    using S = SearchStat;
+    const uint64_t nodes = s[S::Nodes] + s[S::QNodes];
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << prefix << "nodes " << nodes << " qnodes " << s[S::QNodes] << " ("
+        << percent(s[S::QNodes], nodes) << "%)" << std::endl;
+    out << prefix << "tt probes " << s[S::TTProbes] << " hits " << s[S::TTHits] << " ("
+        << percent(s[S::TTHits], s[S::TTProbes]) << "%) cutoffs " << s[S::TTCutoffs] << " ("
+        << percent(s[S::TTCutoffs], s[S::TTProbes]) << "%)" << std::endl;
+    out << prefix << "beta cutoffs " << s[S::BetaCutoffs] << " first move "
+        << percent(s[S::FirstMoveCutoffs], s[S::BetaCutoffs]) << "%" << std::endl;
+    out << prefix << "prunes rfp " << s[S::RfpPrunes] << " futility " << s[S::FutilityPrunes]
+        << " nmp " << s[S::NmpCutoffs] << "/" << s[S::NmpTries] << " ("
+        << percent(s[S::NmpCutoffs], s[S::NmpTries]) << "%)" << std::endl;
+    out << prefix << "re-searches lmr " << s[S::LmrResearches] << "/" << s[S::LmrSearches] << " ("
+        << percent(s[S::LmrResearches], s[S::LmrSearches]) << "%) pvs " << s[S::PvsResearches]
+        << std::endl;
+    out << prefix << "aspiration fail high " << s[S::AspirationFailHighs] << " fail low "
+        << s[S::AspirationFailLows] << std::endl;
+    out << prefix << "evals " << s[S::Evals] << " cache hits "
+        << percent(s[S::EvalCacheHits], s[S::Evals]) << "%" << std::endl;
+    out << prefix << "nnue refreshes " << s[S::NnueRefreshes] << " incremental updates "
+        << s[S::NnueUpdates] << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}  // namespace panda
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+// Set by the PANDA_SEARCH_STATS CMake option. When off, SearchStats::add compiles to nothing
+// and the search carries no counting code at all.
+#ifndef PANDA_SEARCH_STATS
+#define PANDA_SEARCH_STATS 0
+#endif
+
+namespace panda {
+
+constexpr bool SEARCH_STATS_ENABLED = PANDA_SEARCH_STATS != 0;
+
+enum class SearchStat : int {
+    Nodes,   // negamax nodes
+    QNodes,  // quiescence nodes
+    TTProbes,
+    TTHits,
+    TTCutoffs,
+    BetaCutoffs,
+    FirstMoveCutoffs,  // beta cutoffs by the first move searched
+    RfpPrunes,
+    NmpTries,
+    NmpCutoffs,
+    FutilityPrunes,
+    LmrSearches,
+    LmrResearches,
+    PvsResearches,
+    AspirationFailHighs,
+    AspirationFailLows,
+    Evals,  // static evaluations requested
+    EvalCacheHits,
+    NnueRefreshes,  // accumulator stack resets, rebuilt from the refresh caches
+    NnueUpdates,    // moves applied to the accumulators incrementally
+    Count
+};
+
+// Counters of one search thread. Each thread owns one, so counting is a plain increment.
+struct SearchStats {
+    uint64_t counts[int(SearchStat::Count)] = {};
+
+    void add(SearchStat stat, uint64_t n = 1) {
+        if constexpr (SEARCH_STATS_ENABLED)
+            counts[int(stat)] += n;
+    }
+    uint64_t operator[](SearchStat stat) const {
+        return counts[int(stat)];
+    }
+    void merge(const SearchStats& other);
+};
+
+// Totals over every search thread since the last reset. A thread's counters are merged in
+// when its search ends, so a running search is not included yet.
+void merge_search_stats(const SearchStats& stats);
+SearchStats search_stats_totals();
+void reset_search_stats();
+
+// One line per group of counters, with hit rates and shares; every line starts with `prefix`.
+void print_search_stats(const SearchStats& stats, std::ostream& out, const char* prefix = "");
+
+}  // namespace panda
@@ -0,0 +1,46 @@
+#!/bin/sh
+# Usage: check_kernel_isa.sh <objdump> <binary>
+#
+# Checks a PANDA_NNUE_ARCH=dispatch build: instructions beyond x86-64 SSE2 may only appear in
+# the NNUE kernel sets (symbols in the Stockfish_<set> and kernel_<set>_impl namespaces, and
+# the kernel_<set> tables), which run only after dispatch.cpp has checked the CPU. Anything
+# else, such as an inline function shared with the engine or a static initializer, must run
+# on any x86-64 CPU. tzcnt is allowed: it is how objdump shows GCC's rep bsf, which older CPUs
+# execute as bsf.
+
+objdump="$1"
+binary="$2"
+
+"$objdump" -d --no-show-raw-insn -C "$binary" | awk '
+/^[0-9a-f]+ <.*>:$/ {
+    symbol = $0
+    sub(/^[0-9a-f]+ </, "", symbol)
+    sub(/>:$/, "", symbol)
+    kernel = symbol ~ /Stockfish_|kernel_/
+    next
+}
+/^ +[0-9a-f]+:\t/ {
+    split($0, fields, "\t")
+    insn = fields[2]
+    extended = insn ~ /%[yz]mm|%k[0-7]|^v/ ||
+        insn ~ /^(popcnt|lzcnt|andn|bextr|blsi|blsmsk|blsr|bzhi|pdep|pext|mulx|rorx|sarx|shlx|shrx) / ||
+        insn ~ /^(pshufb|palignr|phadd|phsub|pmaddubsw|pmulhrsw|psign|pabs)/ ||
+        insn ~ /^(ptest|pmaxs[bd]|pmins[bd]|pmaxu[wd]|pminu[wd]|pmulld|pmuldq|pblend|blendv?p|pextr[bdq]|pinsr[bdq]|pmov[sz]x|packusdw|pcmpeqq|pcmpgtq|dpp|round[ps]|insertps|extractps|movntdqa|mpsadbw|phminposuw|crc32)/
+    if (!extended)
+        next
+    if (kernel) {
+        kernelCount++
+    } else if (!(symbol in seen)) {
+        seen[symbol] = 1
+        print "outside the kernel sets: " symbol ": " insn
+        failures++
+    }
+}
+END {
+    if (kernelCount == 0) {
+        print "no extended instructions in the kernel sets; is this a dispatch build?"
+        exit 1
+    }
+    printf "%d extended instructions, all inside the kernel sets\n", kernelCount
+    exit failures > 0
+}'
@@ -1,4 +1,11 @@
 #include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "../attacks.h"
@@ -6,6 +13,7 @@
 #include "../eval.h"
 #include "../movegen.h"
 #include "../nnue.h"
+#include "../nnue/weight_blob.h"
 #include "../zobrist.h"
 
 using namespace panda;
@@ -217,6 +225,51 @@ TEST(NnueBackendTest, LoadsSf18V10Nets) {
     set_eval_mode(EvalMode::Handcrafted);
 }
 
+TEST(NnueBatchTest, MatchesSingleEvaluationsInInputOrder) {
+    // Random playouts give many positions sharing king squares, in no particular order
+    std::vector<Board> boards;
+    uint32_t seed = 12345;
+    const char* fens[] = {StartFEN,
+                          "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"};
+    for (const char* fen : fens) {
+        for (int game = 0; game < 4; ++game) {
+            Board board;
+            board.set_fen(fen);
+            for (int ply = 0; ply < 30; ++ply) {
+                MoveList legal = generate_legal(board);
+                if (legal.size() == 0)
+                    break;
+                seed = seed * 1664525u + 1013904223u;
+                board.make_move(legal[int(seed % uint32_t(legal.size()))]);
+                boards.push_back(board);
+            }
+        }
+    }
+
+    std::vector<int> scores = evaluate_nnue_batch(boards);
+    ASSERT_EQ(scores.size(), boards.size());
+    for (std::size_t i = 0; i < boards.size(); ++i)
+        EXPECT_EQ(scores[i], evaluate_nnue(boards[i])) << boards[i].to_fen();
+    EXPECT_TRUE(evaluate_nnue_batch({}).empty());
+}
+
+TEST(NnueOneShotTest, ReusedContextDoesNotLeakBetweenCalls) {
+    if (!nnue_backend_ready())
+        GTEST_SKIP() << "SF18 NNUE nets not available";
+
+    Board first, second;
+    first.set_fen(StartFEN);
+    second.set_fen("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+
+    nnue::SearchNnueContext fresh;
+    fresh.reset(first);
+    const int expected = fresh.evaluate(first);
+
+    EXPECT_EQ(evaluate_nnue(first), expected);
+    evaluate_nnue(second);
+    EXPECT_EQ(evaluate_nnue(first), expected);
+}
+
 TEST(NnueIncrementalTest, MatchesFreshEvalAcrossMakeUnmakeSequence) {
     if (!nnue_backend_ready())
         GTEST_SKIP() << "SF18 NNUE nets not available";
@@ -271,3 +324,266 @@ TEST(NnueIncrementalTest, MatchesFreshEvalAcrossMakeUnmakeSequence) {
         expectParity();
     }
 }
+
+TEST(NnueIncrementalTest, NullMovesShareParentAccumulators) {
+    if (!nnue_backend_ready())
+        GTEST_SKIP() << "SF18 NNUE nets not available";
+
+    Board board;
+    board.set_fen("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+
+    nnue::SearchNnueContext incCtx;
+    incCtx.reset(board);
+
+    auto expectParity = [&]() { EXPECT_EQ(evaluate_nnue(board, &incCtx), evaluate_nnue(board)); };
+
+    uint32_t seed = 0x6C078965u;
+    for (int ply = 0; ply < 12; ++ply) {
+        const Color us = board.side_to_move();
+        if (board.is_square_attacked(lsb(board.pieces(us, King)), ~us))
+            break;
+
+        Board::UndoInfo nullUndo;
+        board.make_null_move(nullUndo);
+        incCtx.on_null_move(board);
+        expectParity();
+
+        // Moves below a null move are pushed and popped on top of the shared state
+        MoveList legal = generate_legal(board);
+        ASSERT_GT(legal.size(), 0);
+        seed = seed * 1664525u + 1013904223u;
+        Move reply = legal[int(seed % uint32_t(legal.size()))];
+        Board::UndoInfo replyUndo;
+        board.make_move(reply, replyUndo);
+        incCtx.on_make_move(board, reply, replyUndo.nnueDirtyPiece, replyUndo.nnueDirtyThreats);
+        expectParity();
+        board.unmake_move(reply, replyUndo);
+        incCtx.on_unmake_move(board);
+
+        board.unmake_null_move(nullUndo);
+        incCtx.on_unmake_null_move(board);
+        expectParity();
+
+        legal = generate_legal(board);
+        ASSERT_GT(legal.size(), 0);
+        seed = seed * 1664525u + 1013904223u;
+        Move m = legal[int(seed % uint32_t(legal.size()))];
+        Board::UndoInfo undo;
+        board.make_move(m, undo);
+        incCtx.on_make_move(board, m, undo.nnueDirtyPiece, undo.nnueDirtyThreats);
+        expectParity();
+    }
+}
+
+// ============================================================
+// NNUE threat features from board deltas
+// ============================================================
+
+// Every (attacker, attacked) pair on the board, as counted by the FullThreats features.
+static std::map<uint32_t, int> allThreats(const Board& board) {
+    std::map<uint32_t, int> threats;
+    Bitboard occupied = board.all_pieces();
+    Bitboard bb = occupied;
+    while (bb) {
+        Square from = pop_lsb(bb);
+        Piece pc = board.piece_on(from);
+        Bitboard targets;
+        switch (piece_type(pc)) {
+            case Pawn:
+                targets = attacks::pawn_attacks(piece_color(pc), from);
+                break;
+            case Knight:
+                targets = attacks::knight_attacks(from);
+                break;
+            case Bishop:
+                targets = attacks::bishop_attacks(from, occupied);
+                break;
+            case Rook:
+                targets = attacks::rook_attacks(from, occupied);
+                break;
+            case Queen:
+                targets = attacks::queen_attacks(from, occupied);
+                break;
+            default:
+                targets = attacks::king_attacks(from);
+                break;
+        }
+        targets &= occupied;
+        while (targets) {
+            Square to = pop_lsb(targets);
+            threats[nnue::DirtyThreat(pc, board.piece_on(to), from, to, false).raw()]++;
+        }
+    }
+    return threats;
+}
+
+TEST(NnueThreatsTest, PackedFieldsDecodeIndependently) {
+    for (int pc = 0; pc < PieceCount; ++pc) {
+        for (int threatened = 0; threatened < PieceCount; ++threatened) {
+            for (bool add : {false, true}) {
+                const nnue::DirtyThreat t(Piece(pc), Piece(threatened), Square(63 - pc),
+                                          Square(threatened), add);
+                EXPECT_EQ(t.pc(), Piece(pc));
+                EXPECT_EQ(t.threatened_pc(), Piece(threatened));
+                EXPECT_EQ(t.pc_sq(), Square(63 - pc));
+                EXPECT_EQ(t.threatened_sq(), Square(threatened));
+                EXPECT_EQ(t.add(), add);
+            }
+        }
+    }
+}
+
+TEST(NnueThreatsTest, MoveDeltaMatchesRecomputedThreats) {
+    const char* fens[] = {
+        StartFEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+
+    uint32_t seed = 0x2545F491u;
+    int checkedMoves = 0;
+    for (const char* fen : fens) {
+        for (int game = 0; game < 8; ++game) {
+            Board board;
+            board.set_fen(fen);
+            for (int ply = 0; ply < 40; ++ply) {
+                MoveList legal = generate_legal(board);
+                if (legal.size() == 0)
+                    break;
+                seed = seed * 1664525u + 1013904223u;
+                Move m = legal[int(seed % uint32_t(legal.size()))];
+
+                std::map<uint32_t, int> expected = allThreats(board);
+                const Board before = board;
+                Board::UndoInfo undo;
+                board.make_move(m, undo);
+
+                nnue::DirtyThreats delta;
+                ASSERT_TRUE(nnue::append_move_threats(board, undo.nnueDirtyPiece, delta));
+                for (const nnue::DirtyThreat& t : delta.list) {
+                    uint32_t key = nnue::DirtyThreat(t.pc(), t.threatened_pc(), t.pc_sq(),
+                                                     t.threatened_sq(), false)
+                                       .raw();
+                    expected[key] += t.add() ? 1 : -1;
+                    if (expected[key] == 0)
+                        expected.erase(key);
+                }
+
+                ASSERT_EQ(expected, allThreats(board))
+                    << board.to_fen() << " after " << move_to_uci(m);
+
+                // Unwinding records the same delta and restores the placement before the move
+                Board unwound = board;
+                nnue::DirtyThreats unwoundDelta;
+                ASSERT_TRUE(nnue::unwind_move_threats(unwound, undo.nnueDirtyPiece, unwoundDelta));
+                EXPECT_EQ(unwoundDelta.list.size(), delta.list.size());
+                for (int sq = 0; sq < 64; ++sq)
+                    ASSERT_EQ(unwound.piece_on(Square(sq)), before.piece_on(Square(sq)));
+                ++checkedMoves;
+            }
+        }
+    }
+    EXPECT_GT(checkedMoves, 500);
+}
+
+// ============================================================
+// NNUE weight blobs
+// ============================================================
+
+#if defined(__unix__) || defined(__APPLE__)
+
+static nnue::WeightBlobHeader blobHeader(uint64_t payloadSize) {
+    nnue::WeightBlobHeader header;
+    std::strncpy(header.kernel, "sse2", sizeof(header.kernel) - 1);
+    header.payloadSize = payloadSize;
+    header.bigNetHash = 1000;
+    header.smallNetHash = 100;
+    return header;
+}
+
+TEST(NnueWeightBlobTest, MapsWhatWasWritten) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "panda_blob_roundtrip.bin").string();
+    std::vector<int32_t> weights(5000);
+    for (int i = 0; i < int(weights.size()); ++i) weights[i] = i * 7 - 300;
+    const auto header = blobHeader(weights.size() * sizeof(int32_t));
+
+    ASSERT_TRUE(nnue::WeightBlob::write(path, header, weights.data()));
+    nnue::WeightBlob blob = nnue::WeightBlob::map(path, header);
+    ASSERT_TRUE(blob);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(blob.payload()) % 4096, 0u);
+    EXPECT_EQ(std::memcmp(blob.payload(), weights.data(), header.payloadSize), 0);
+
+    // Net hashes of zero mean the source nets were not found, so they are not checked
+    auto noNets = header;
+    noNets.bigNetHash = noNets.smallNetHash = 0;
+    EXPECT_TRUE(nnue::WeightBlob::map(path, noNets));
+
+    std::filesystem::remove(path);
+}
+
+TEST(NnueWeightBlobTest, RejectsStaleOrForeignBlobs) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "panda_blob_stale.bin").string();
+    std::vector<char> payload(256, 'x');
+    const auto header = blobHeader(payload.size());
+    ASSERT_TRUE(nnue::WeightBlob::write(path, header, payload.data()));
+
+    auto otherKernel = header;
+    std::strncpy(otherKernel.kernel, "avx2", sizeof(otherKernel.kernel) - 1);
+    EXPECT_FALSE(nnue::WeightBlob::map(path, otherKernel));
+
+    auto otherNet = header;
+    otherNet.bigNetHash = 2000;
+    EXPECT_FALSE(nnue::WeightBlob::map(path, otherNet));
+
+    auto otherLayout = header;
+    otherLayout.payloadSize = 512;
+    EXPECT_FALSE(nnue::WeightBlob::map(path, otherLayout));
+
+    std::filesystem::remove(path);
+    EXPECT_FALSE(nnue::WeightBlob::map(path, header));
+}
+
+TEST(NnueWeightBlobTest, ReplacingANetWithOneOfTheSameSizeMakesTheBlobStale) {
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string netPath = (dir / "panda_blob_net.nnue").string();
+    const std::string blobPath = (dir / "panda_blob_replaced.bin").string();
+    auto writeNet = [&](char fill) {
+        std::vector<char> bytes(100000, fill);
+        bytes[12345] = 'k';
+        std::ofstream(netPath, std::ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+    };
+
+    writeNet('a');
+    const uint64_t original = nnue::file_content_hash(netPath);
+    EXPECT_NE(original, 0u);
+    EXPECT_EQ(nnue::file_content_hash(netPath), original);
+
+    std::vector<char> payload(256, 'x');
+    auto header = blobHeader(payload.size());
+    header.bigNetHash = original;
+    ASSERT_TRUE(nnue::WeightBlob::write(blobPath, header, payload.data()));
+    EXPECT_TRUE(nnue::WeightBlob::map(blobPath, header));
+
+    // Same size, same path, different bytes
+    writeNet('b');
+    ASSERT_EQ(std::filesystem::file_size(netPath), 100000u);
+    header.bigNetHash = nnue::file_content_hash(netPath);
+    EXPECT_NE(header.bigNetHash, original);
+    EXPECT_FALSE(nnue::WeightBlob::map(blobPath, header));
+
+    // Writing the original bytes back makes the blob valid again
+    writeNet('a');
+    header.bigNetHash = nnue::file_content_hash(netPath);
+    EXPECT_EQ(header.bigNetHash, original);
+    EXPECT_TRUE(nnue::WeightBlob::map(blobPath, header));
+
+    EXPECT_EQ(nnue::file_content_hash((dir / "panda_blob_missing.nnue").string()), 0u);
+    std::filesystem::remove(netPath);
+    std::filesystem::remove(blobPath);
+}
+
+#endif
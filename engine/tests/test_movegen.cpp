@@ -1,9 +1,15 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
 #include "../attacks.h"
 #include "../board.h"
 #include "../move.h"
 #include "../movegen.h"
+#include "../perft.h"
 #include "../zobrist.h"
 
 using namespace panda;
@@ -343,6 +349,27 @@ TEST(MakeMoveTest, UnmakeRoundtripPromotionCapture) {
     EXPECT_EQ(board.hash_key(), board.compute_hash());
 }
 
+TEST(MakeMoveTest, KeyAfterMatchesMakeMove) {
+    const char* fens[] = {
+        StartFEN,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "r3k2r/8/8/8/8/8/6p1/R3K2R b KQkq - 0 1",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        board.set_fen(fen);
+        for (Move m : generate_legal(board)) {
+            uint64_t predicted = board.key_after(m);
+            Board::UndoInfo undo;
+            board.make_move(m, undo);
+            EXPECT_EQ(predicted, board.hash_key()) << fen << " " << move_to_uci(m);
+            board.unmake_move(m, undo);
+        }
+    }
+}
+
 TEST(MakeMoveTest, UnmakeRoundtripNullMove) {
     Board board;
     board.set_fen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
@@ -421,6 +448,240 @@ TEST(PerftTest, KiwipeteDepth4) {
     EXPECT_EQ(perft(board, 4), 4085603ULL);
 }
 
+// Position 3 from the CPW perft suite: en passant discovered checks and rank pins.
+constexpr const char* PinnedEnPassantFEN = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -";
+
+TEST(PerftTest, PinnedEnPassantDepth4) {
+    Board board;
+    board.set_fen(PinnedEnPassantFEN);
+    EXPECT_EQ(perft(board, 4), 43238ULL);
+}
+
+TEST(PerftTest, PinnedEnPassantDepth5) {
+    Board board;
+    board.set_fen(PinnedEnPassantFEN);
+    EXPECT_EQ(perft(board, 5), 674624ULL);
+}
+
+// Position 4 from the CPW perft suite: checks, evasions and promotions from the first ply.
+TEST(PerftTest, EvasionsDepth4) {
+    Board board;
+    board.set_fen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    EXPECT_EQ(perft(board, 4), 422333ULL);
+}
+
+// Position 5 from the CPW perft suite.
+TEST(PerftTest, PromotionDiscoveredCheckDepth3) {
+    Board board;
+    board.set_fen("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8");
+    EXPECT_EQ(perft(board, 3), 62379ULL);
+}
+
+TEST(PerftTest, LegalMovesNeverLeaveKingInCheck) {
+    const char* fens[] = {
+        KiwipeteFEN,
+        PinnedEnPassantFEN,
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "4k3/8/8/2KPp2r/8/8/8/8 w - e6 0 1",
+        "4k3/8/8/8/1b6/8/3P4/4K3 w - - 0 1",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        board.set_fen(fen);
+        Color us = board.side_to_move();
+        MoveList legal = generate_legal(board);
+        for (Move m : legal) {
+            Board::UndoInfo undo;
+            board.make_move(m, undo);
+            EXPECT_FALSE(board.is_square_attacked(lsb(board.pieces(us, King)), ~us))
+                << fen << " " << move_to_uci(m);
+            board.unmake_move(m, undo);
+        }
+    }
+}
+
+// ============================================================
+// Threaded and hashed perft
+// ============================================================
+
+TEST(PerftDivideTest, DivideSumsToTotal) {
+    Board board;
+    board.set_fen(StartFEN);
+    PerftResult result = perft_divide(board, 3, PerftOptions{});
+    EXPECT_EQ(result.nodes, 8902ULL);
+    ASSERT_EQ(result.divide.size(), 20U);
+
+    uint64_t sum = 0;
+    for (const auto& [move, nodes] : result.divide) {
+        sum += nodes;
+        if (move_to_uci(move) == "e2e4") {
+            EXPECT_EQ(nodes, 600ULL);
+        }
+    }
+    EXPECT_EQ(sum, result.nodes);
+}
+
+TEST(PerftDivideTest, ThreadedHashedMatchesSerial) {
+    PerftOptions options;
+    options.threads = 4;
+    options.hashMB = 4;
+
+    Board board;
+    board.set_fen(KiwipeteFEN);
+    EXPECT_EQ(perft_divide(board, 4, options).nodes, 4085603ULL);
+
+    // En passant squares are part of the key, so transpositions that differ only in them
+    // must not share counts
+    board.set_fen(PinnedEnPassantFEN);
+    EXPECT_EQ(perft_divide(board, 5, options).nodes, 674624ULL);
+}
+
+TEST(PerftDivideTest, FullLeafCountingMatchesBulk) {
+    PerftOptions options;
+    options.threads = 2;
+    options.bulk = false;
+
+    Board board;
+    board.set_fen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    EXPECT_EQ(perft_divide(board, 3, options).nodes, 9467ULL);
+}
+
+TEST(PerftDivideTest, TinyHashStillExact) {
+    // Almost every store overwrites another subtree; counts must still be exact
+    PerftOptions options;
+    options.threads = 3;
+    options.hashMB = 1;
+
+    Board board;
+    board.set_fen(StartFEN);
+    EXPECT_EQ(perft_divide(board, 5, options).nodes, 4865609ULL);
+}
+
+TEST(PerftDivideTest, CommandParsesDepthAndFen) {
+    Board board;
+    board.set_fen(StartFEN);
+    std::istringstream args("3 2 1 fen 8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1");
+    std::ostringstream out;
+    EXPECT_EQ(perft_command(board, args, out, true), 2812ULL);
+    EXPECT_NE(out.str().find("b4b1: "), std::string::npos);
+}
+
+TEST(PerftDivideTest, StopFlagEndsCountEarly) {
+    // Depth 8 would run for minutes; "stop" from the UCI thread must end it promptly
+    std::atomic<bool> stop{false};
+    std::thread stopper([&stop]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stop.store(true, std::memory_order_relaxed);
+    });
+
+    Board board;
+    board.set_fen(StartFEN);
+    std::istringstream args("8 2 4");
+    std::ostringstream out;
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = perft_command(board, args, out, true, &stop);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stopper.join();
+
+    EXPECT_LT(nodes, 84998978956ULL);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_NE(out.str().find("Stopped"), std::string::npos);
+    EXPECT_EQ(out.str().find("e2e4: "), std::string::npos);
+}
+
+// ============================================================
+// Generation modes
+// ============================================================
+
+static bool containsMove(const MoveList& moves, Move m) {
+    for (Move x : moves) {
+        if (x == m)
+            return true;
+    }
+    return false;
+}
+
+static bool isTacticalMove(const Board& board, Move m) {
+    return move_type(m) == EnPassant || move_type(m) == Promotion ||
+           board.piece_on(move_to(m)) != NoPiece;
+}
+
+TEST(GenTypeTest, CapturesAndQuietsPartitionLegalMoves) {
+    const char* fens[] = {
+        StartFEN,
+        KiwipeteFEN,
+        PinnedEnPassantFEN,
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "4k3/8/8/2KPp2r/8/8/8/8 w - e6 0 1",
+        "4k3/8/8/8/8/8/4r3/R3K2R w KQ - 0 1",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        board.set_fen(fen);
+        MoveList legal = generate_legal(board);
+        MoveList captures = generate_legal(board, GenType::Captures);
+        MoveList quiets = generate_legal(board, GenType::Quiets);
+
+        EXPECT_EQ(captures.size() + quiets.size(), legal.size()) << fen;
+        for (Move m : captures) {
+            EXPECT_TRUE(isTacticalMove(board, m)) << fen << " " << move_to_uci(m);
+            EXPECT_TRUE(containsMove(legal, m)) << fen << " " << move_to_uci(m);
+        }
+        for (Move m : quiets) {
+            EXPECT_FALSE(isTacticalMove(board, m)) << fen << " " << move_to_uci(m);
+            EXPECT_TRUE(containsMove(legal, m)) << fen << " " << move_to_uci(m);
+        }
+    }
+}
+
+TEST(GenTypeTest, CapturesIncludeQuietPromotions) {
+    Board board;
+    board.set_fen("4k3/P7/8/8/8/8/8/4K3 w - - 0 1");
+
+    MoveList captures = generate_legal(board, GenType::Captures);
+    EXPECT_EQ(captures.size(), 4);
+    for (Move m : captures)
+        EXPECT_EQ(move_type(m), Promotion);
+}
+
+TEST(GenTypeTest, EvasionsMatchLegalMovesInCheck) {
+    const char* fens[] = {
+        "4k3/8/8/8/8/8/4r3/R3K2R w KQ - 0 1",
+        "4k3/8/8/8/1b6/8/8/4K3 w - - 0 1",
+        "4k3/8/8/8/8/5n2/8/4K2r w - - 0 1",
+    };
+    for (const char* fen : fens) {
+        Board board;
+        board.set_fen(fen);
+        ASSERT_TRUE(in_check(board)) << fen;
+
+        MoveList legal = generate_legal(board);
+        MoveList evasions = generate_legal(board, GenType::Evasions);
+        EXPECT_EQ(evasions.size(), legal.size()) << fen;
+        for (Move m : evasions)
+            EXPECT_TRUE(containsMove(legal, m)) << fen << " " << move_to_uci(m);
+    }
+}
+
+TEST(GenTypeTest, HasLegalMoves) {
+    Board board;
+    board.set_fen(StartFEN);
+    EXPECT_TRUE(has_legal_moves(board));
+
+    // Stalemate
+    board.set_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    EXPECT_FALSE(has_legal_moves(board));
+
+    // Checkmate
+    board.set_fen("rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    EXPECT_FALSE(has_legal_moves(board));
+
+    // King boxed in, but a pawn can still push
+    board.set_fen("7k/5Q2/6K1/8/8/8/p7/8 b - - 0 1");
+    EXPECT_TRUE(has_legal_moves(board));
+}
+
 // ============================================================
 // Game termination tests
 // ============================================================
@@ -1,13 +1,26 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 #include "../attacks.h"
+#include "../bench.h"
 #include "../board.h"
 #include "../eval.h"
 #include "../move.h"
 #include "../movegen.h"
 #include "../search.h"
+#include "../search_stats.h"
 #include "../tt.h"
 #include "../zobrist.h"
 
@@ -81,8 +94,57 @@ TEST(TTTest, Clear) {
     EXPECT_FALSE(tt.probe(key, entry));
 }
 
-TEST(TTTest, CollisionKeepsDeeperEntry) {
-    TranspositionTable tt(0);  // Force one-slot table (mask = 0)
+TEST(TTTest, FailedResizeKeepsUsableTable) {
+    TranspositionTable tt(1);
+    // Far beyond any address space, so the allocation fails on every host
+    EXPECT_THROW(tt.resize(size_t(1) << 30), std::bad_alloc);
+
+    uint64_t key = 0x123456789ABCDEF0ULL;
+    tt.store(key, 42, 5, TT_EXACT, make_move(E2, E4));
+    TTEntry entry;
+    ASSERT_TRUE(tt.probe(key, entry));
+    EXPECT_EQ(entry.score, 42);
+
+#if defined(__linux__)
+    // Cap the address space below what is mapped now, so once the 64 MB table is freed
+    // neither the new size nor the old one fits again.
+    tt.resize(64);
+    std::ifstream statm("/proc/self/statm");
+    size_t mappedPages = 0;
+    ASSERT_TRUE(statm >> mappedPages);
+    const size_t mappedBytes = mappedPages * size_t(sysconf(_SC_PAGESIZE));
+    rlimit saved{};
+    ASSERT_EQ(getrlimit(RLIMIT_AS, &saved), 0);
+    rlimit capped = saved;
+    capped.rlim_cur = mappedBytes - 32 * 1024 * 1024;
+    ASSERT_EQ(setrlimit(RLIMIT_AS, &capped), 0);
+    bool threw = false;
+    try {
+        tt.resize(128);
+    } catch (const std::bad_alloc&) {
+        threw = true;
+    }
+    setrlimit(RLIMIT_AS, &saved);
+    EXPECT_TRUE(threw);
+
+    tt.prefetch(key);
+    tt.store(key, 17, 3, TT_BETA, make_move(D2, D4));
+    ASSERT_TRUE(tt.probe(key, entry));
+    EXPECT_EQ(entry.score, 17);
+    EXPECT_EQ(tt.hashfull_permille(), 1000 / TT_BUCKET_SLOTS);  // one slot of one bucket
+#endif
+}
+
+// Fills the single bucket of a TranspositionTable(0) with distinct keys.
+static void fillBucket(TranspositionTable& tt, int depth, TTFlag flag) {
+    for (int i = 0; i < TT_BUCKET_SLOTS; ++i) {
+        uint64_t key = (0xA000ULL + i) << 48;
+        tt.store(key, 100, depth, flag, make_move(E2, E4));
+    }
+}
+
+TEST(TTTest, BucketHoldsSeveralCollidingKeys) {
+    TranspositionTable tt(0);  // Force one-bucket table (mask = 0)
     uint64_t keyA = 0x123456789ABCDEF0ULL;
     uint64_t keyB = 0x0FEDCBA987654321ULL;
 
@@ -90,40 +152,93 @@ TEST(TTTest, CollisionKeepsDeeperEntry) {
     tt.store(keyB, 50, 4, TT_BETA, make_move(D2, D4));
 
     TTEntry entry;
-    EXPECT_TRUE(tt.probe(keyA, entry));
+    ASSERT_TRUE(tt.probe(keyA, entry));
+    EXPECT_EQ(entry.score, 100);
+    ASSERT_TRUE(tt.probe(keyB, entry));
+    EXPECT_EQ(entry.score, 50);
+    EXPECT_EQ(entry.bestMove, make_move(D2, D4));
+}
+
+TEST(TTTest, CollisionKeepsDeeperEntry) {
+    TranspositionTable tt(0);  // Force one-bucket table (mask = 0)
+    uint64_t keyB = 0x0FEDCBA987654321ULL;
+
+    fillBucket(tt, 10, TT_ALPHA);
+    tt.store(keyB, 50, 4, TT_BETA, make_move(D2, D4));
+
+    TTEntry entry;
+    EXPECT_TRUE(tt.probe(0xA000ULL << 48, entry));
     EXPECT_FALSE(tt.probe(keyB, entry));
 }
 
 TEST(TTTest, CollisionPrefersExactAtEqualDepth) {
-    TranspositionTable tt(0);  // Force one-slot table (mask = 0)
-    uint64_t keyA = 0x1111111111111111ULL;
+    TranspositionTable tt(0);  // Force one-bucket table (mask = 0)
     uint64_t keyB = 0x2222222222222222ULL;
 
-    tt.store(keyA, 10, 6, TT_ALPHA, make_move(E2, E4));
+    fillBucket(tt, 6, TT_ALPHA);
     tt.store(keyB, 20, 6, TT_EXACT, make_move(D2, D4));
 
     TTEntry entry;
-    EXPECT_FALSE(tt.probe(keyA, entry));
     ASSERT_TRUE(tt.probe(keyB, entry));
     EXPECT_EQ(entry.depth, 6);
     EXPECT_EQ(entry.flag, TT_EXACT);
 }
 
 TEST(TTTest, CollisionReplacedWhenStale) {
-    TranspositionTable tt(0);  // Force one-slot table (mask = 0)
-    uint64_t keyA = 0x3333333333333333ULL;
+    TranspositionTable tt(0);  // Force one-bucket table (mask = 0)
     uint64_t keyB = 0x4444444444444444ULL;
 
-    tt.store(keyA, 100, 10, TT_EXACT, make_move(E2, E4));
+    fillBucket(tt, 10, TT_EXACT);
     tt.new_search();
     tt.new_search();
     tt.store(keyB, 25, 2, TT_ALPHA, make_move(D2, D4));
 
     TTEntry entry;
-    EXPECT_FALSE(tt.probe(keyA, entry));
     EXPECT_TRUE(tt.probe(keyB, entry));
 }
 
+TEST(TTTest, MateScoresSurviveCompactStorage) {
+    TranspositionTable tt(1);
+    uint64_t keyA = 0x6666666666666666ULL;
+    uint64_t keyB = 0x7777777777777777ULL;
+
+    tt.store(keyA, MATE_SCORE - 3, 12, TT_EXACT, make_move(E2, E4));
+    tt.store(keyB, -MATE_SCORE + 5, 12, TT_EXACT, make_move(D2, D4));
+
+    TTEntry entry;
+    ASSERT_TRUE(tt.probe(keyA, entry));
+    EXPECT_EQ(entry.score, MATE_SCORE - 3);
+    ASSERT_TRUE(tt.probe(keyB, entry));
+    EXPECT_EQ(entry.score, -MATE_SCORE + 5);
+}
+
+TEST(TTTest, ConcurrentStoresNeverTearEntries) {
+    TranspositionTable tt(1);
+    // Every payload is derived from its key, so a slot mixing two stores is detectable.
+    auto keyFor = [](uint64_t i) { return (i << 48) | ((i * 0x9E3779B97F4A7C15ULL) >> 16); };
+    auto scoreFor = [](uint64_t i) { return int(i % 20000) - 10000; };
+    auto moveFor = [](uint64_t i) { return Move((i * 7919) | 1); };
+
+    std::atomic<int> torn{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            for (uint64_t n = 0; n < 200000; ++n) {
+                uint64_t i = (n * 31 + t * 7777) & 0xFFFF;
+                tt.store(keyFor(i), scoreFor(i), int(i % 40), TT_EXACT, moveFor(i));
+                TTEntry entry;
+                uint64_t j = (i * 13) & 0xFFFF;
+                if (tt.probe(keyFor(j), entry) &&
+                    (entry.score != scoreFor(j) || entry.bestMove != moveFor(j)))
+                    torn.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    EXPECT_EQ(torn.load(), 0);
+}
+
 TEST(TTTest, SameKeyShallowerBoundDoesNotDegrade) {
     TranspositionTable tt(1);
     uint64_t key = 0x5555555555555555ULL;
@@ -266,6 +381,66 @@ TEST(SearchTest, IterativeDeepeningReturnsMove) {
     EXPECT_LT(elapsed, 2000);
 }
 
+TEST(SearchTest, SmpDeadlineStopsHelpers) {
+    Board board;
+    board.set_fen(StartFEN);
+
+    TranspositionTable tt(1);
+    std::atomic<bool> stopFlag{false};
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result = search(board, 200, 0, tt, stopFlag, {}, 3);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    EXPECT_NE(result.bestMove, NullMove);
+    EXPECT_TRUE(stopFlag.load());
+    // Only the main thread watches the clock; helpers must still stop promptly.
+    EXPECT_LT(elapsed, 1000);
+}
+
+TEST(SearchTest, SmpVoteKeepsMateAndLegalMove) {
+    Board board;
+    board.set_fen("6k1/5ppp/8/8/8/8/8/K6Q w - - 0 1");
+
+    TranspositionTable tt(4);
+    std::atomic<bool> stopFlag{false};
+    SearchResult result = search(board, 0, 6, tt, stopFlag, {}, 4);
+
+    Board after = board;
+    after.make_move(result.bestMove);
+    EXPECT_TRUE(is_checkmate(after));
+    EXPECT_GT(result.score, MATE_SCORE - 100);
+}
+
+TEST(SearchTest, SmpInfoReportsDeepestCompletedDepth) {
+    Board board;
+    board.set_fen("r1bqkb1r/pp1n1ppp/2n1p3/2ppP3/3P4/2PB4/PP1N1PPP/R1BQK1NR w KQkq - 2 7");
+
+    TranspositionTable tt(4);
+    std::atomic<bool> stopFlag{false};
+    std::vector<SearchInfo> infos;
+    auto infoCb = [&infos](const SearchInfo& info) { infos.push_back(info); };
+    SearchResult result = search(board, 0, 6, tt, stopFlag, {}, 4, infoCb);
+
+    // Depth never falls while iterations complete. Only the very last line may be shallower:
+    // when a helper's move wins the vote, its own iteration is reported.
+    ASSERT_FALSE(infos.empty());
+    int deepest = 0;
+    for (std::size_t i = 0; i < infos.size(); ++i) {
+        if (i > 0 && i + 1 < infos.size()) {
+            EXPECT_GE(infos[i].depth, infos[i - 1].depth);
+        }
+        deepest = std::max(deepest, infos[i].depth);
+    }
+    EXPECT_EQ(deepest, 6);
+    // The last line reported is the iteration behind the move played
+    ASSERT_FALSE(infos.back().pv.empty());
+    EXPECT_EQ(infos.back().pv[0], result.bestMove);
+    EXPECT_EQ(infos.back().score, result.score);
+    EXPECT_TRUE(is_legal(board, result.bestMove));
+}
+
 TEST(SearchTest, IterativeDeepeningFindsMate) {
     // Mate in 1 should be found almost instantly
     Board board;
@@ -280,6 +455,46 @@ TEST(SearchTest, IterativeDeepeningFindsMate) {
     EXPECT_GT(result.score, MATE_SCORE - 100);
 }
 
+// ============================================================
+// Static exchange evaluation
+// ============================================================
+
+TEST(SeeTest, PawnTakesDefendedKnight) {
+    Board board;
+    board.set_fen("4k3/8/2p5/3n4/4P3/8/8/4K3 w - - 0 1");
+    EXPECT_EQ(staticExchangeEvalForTests(board, findMoveByUci(board, "e4d5")),
+              PieceValue[Knight] - PieceValue[Pawn]);
+}
+
+TEST(SeeTest, QueenTakesDefendedPawn) {
+    Board board;
+    board.set_fen("4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1");
+    EXPECT_EQ(staticExchangeEvalForTests(board, findMoveByUci(board, "d1d5")),
+              PieceValue[Pawn] - PieceValue[Queen]);
+}
+
+// Each gain term is the value of the piece standing on the square, not of the recapturer:
+// PxN stays a knight-for-pawn win when the recapture is made by a queen.
+TEST(SeeTest, RecaptureByQueenCountsPieceOnSquare) {
+    Board board;
+    board.set_fen("3qk3/8/8/3n4/4P3/8/8/4K3 w - - 0 1");
+    EXPECT_EQ(staticExchangeEvalForTests(board, findMoveByUci(board, "e4d5")),
+              PieceValue[Knight] - PieceValue[Pawn]);
+}
+
+TEST(SeeTest, KingDoesNotRecaptureOntoDefendedSquare) {
+    Board board;
+    board.set_fen("8/8/4k3/3p4/8/8/6B1/3RK3 w - - 0 1");
+    EXPECT_EQ(staticExchangeEvalForTests(board, findMoveByUci(board, "d1d5")), PieceValue[Pawn]);
+}
+
+TEST(SeeTest, KingRecapturesUndefendedPiece) {
+    Board board;
+    board.set_fen("8/8/4k3/3p4/8/8/8/3RK3 w - - 0 1");
+    EXPECT_EQ(staticExchangeEvalForTests(board, findMoveByUci(board, "d1d5")),
+              PieceValue[Pawn] - PieceValue[Rook]);
+}
+
 // ============================================================
 // Quiescence regression tests
 // ============================================================
@@ -377,6 +592,103 @@ TEST(SearchTest, TwofoldRepetitionIsNotForcedDraw) {
     EXPECT_GT(result.score, 200);
 }
 
+TEST(SearchTest, HistoryPersistsUntilHeuristicsAreCleared) {
+    Board board;
+    board.set_fen("r1bqkb1r/pp1n1ppp/2n1p3/2ppP3/3P4/2PB4/PP1N1PPP/R1BQK1NR w KQkq - 2 7");
+
+    TranspositionTable tt(16);
+    std::atomic<bool> stopFlag{false};
+    auto nodesOfFreshTtSearch = [&]() {
+        tt.clear();
+        uint64_t nodes = 0;
+        search(board, TimeLimits{}, 6, tt, stopFlag, {board.hash_key()}, 1,
+               [&nodes](const SearchInfo& info) { nodes = info.nodes; });
+        return nodes;
+    };
+
+    clear_search_heuristics();
+    uint64_t fresh = nodesOfFreshTtSearch();
+    // Same position and an empty TT, but the aged history of the first search reorders moves
+    EXPECT_NE(nodesOfFreshTtSearch(), fresh);
+
+    clear_search_heuristics();
+    EXPECT_EQ(nodesOfFreshTtSearch(), fresh);
+}
+
+// ============================================================
+// Bench
+// ============================================================
+
+TEST(BenchTest, SingleThreadSignatureIsDeterministic) {
+    auto runBench = [](std::string& output) {
+        std::istringstream args("4 1 4");
+        std::ostringstream out;
+        uint64_t nodes = bench(args, out);
+        output = out.str();
+        return nodes;
+    };
+
+    std::string first, second;
+    uint64_t nodes = runBench(first);
+    EXPECT_GT(nodes, 0u);
+    EXPECT_EQ(runBench(second), nodes);
+    EXPECT_NE(first.find("depth 4"), std::string::npos);
+    EXPECT_NE(first.find("Nodes searched  : " + std::to_string(nodes)), std::string::npos);
+}
+
+TEST(BenchTest, RestoresConfiguredThreadCount) {
+    set_search_threads(1);
+    std::istringstream args("4 3 2");
+    std::ostringstream out;
+    bench(args, out);
+    EXPECT_EQ(search_threads(), 1);
+}
+
+static std::vector<uint64_t> benchNodesPerPosition(const char* args) {
+    std::istringstream in(args);
+    std::ostringstream out;
+    bench(in, out);
+
+    std::vector<uint64_t> nodes;
+    std::istringstream lines(out.str());
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.rfind("Position ", 0) != 0)
+            continue;
+        const std::size_t colon = line.find(": ");
+        if (colon != std::string::npos)
+            nodes.push_back(std::stoull(line.substr(colon + 2)));
+    }
+    return nodes;
+}
+
+TEST(BenchTest, EveryPositionIsSearchedWithHelperThreads) {
+    // A stale stop flag cut every position after the first to a few hundred nodes. Forced
+    // mates legitimately finish early, so compare against a single-threaded run instead of
+    // a fixed floor.
+    const std::vector<uint64_t> single = benchNodesPerPosition("4 1 5");
+    const std::vector<uint64_t> threaded = benchNodesPerPosition("4 2 5");
+    ASSERT_EQ(single.size(), 18u);
+    ASSERT_EQ(threaded.size(), single.size());
+    for (std::size_t i = 0; i < single.size(); ++i)
+        EXPECT_GE(threaded[i] * 4, single[i]) << "position " << i + 1;
+}
+
+// ============================================================
+// Search stats
+// ============================================================
+
+// The counters themselves are tested by test_search_stats, which is built with them.
+TEST(SearchStatsTest, CountsNothingWhenCompiledOut) {
+    if (SEARCH_STATS_ENABLED)
+        GTEST_SKIP() << "search stats are compiled in";
+
+    std::istringstream args("4 1 3");
+    std::ostringstream out;
+    bench(args, out);
+    EXPECT_EQ(search_stats_totals()[SearchStat::Nodes], 0u);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     ::testing::AddGlobalTestEnvironment(new SearchTestEnvironment());
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "../attacks.h"
+#include "../bench.h"
+#include "../eval.h"
+#include "../search_stats.h"
+#include "../zobrist.h"
+
+using namespace panda;
+
+// Linked against engine_stats, the copy of the engine built with PANDA_SEARCH_STATS=1, so the
+// counters are exercised even when the default build compiles them out.
+static_assert(SEARCH_STATS_ENABLED, "test_search_stats must be built with PANDA_SEARCH_STATS=1");
+
+class SearchStatsEnvironment : public ::testing::Environment {
+   public:
+    void SetUp() override {
+        zobrist::init();
+        attacks::init();
+        set_eval_mode(EvalMode::Handcrafted);
+    }
+};
+
+static uint64_t runBench(const char* args, std::string* output = nullptr) {
+    reset_search_stats();
+    std::istringstream in(args);
+    std::ostringstream out;
+    uint64_t nodes = bench(in, out);
+    if (output)
+        *output = out.str();
+    return nodes;
+}
+
+TEST(SearchStatsTest, CountersMatchBenchNodes) {
+    std::string output;
+    uint64_t nodes = runBench("4 1 5", &output);
+
+    SearchStats totals = search_stats_totals();
+    EXPECT_EQ(totals[SearchStat::Nodes] + totals[SearchStat::QNodes], nodes);
+    EXPECT_GT(totals[SearchStat::TTHits], 0u);
+    EXPECT_LE(totals[SearchStat::TTCutoffs], totals[SearchStat::TTHits]);
+    EXPECT_LE(totals[SearchStat::TTHits], totals[SearchStat::TTProbes]);
+    EXPECT_GT(totals[SearchStat::BetaCutoffs], 0u);
+    EXPECT_LE(totals[SearchStat::FirstMoveCutoffs], totals[SearchStat::BetaCutoffs]);
+    EXPECT_LE(totals[SearchStat::NmpCutoffs], totals[SearchStat::NmpTries]);
+    EXPECT_LE(totals[SearchStat::LmrResearches], totals[SearchStat::LmrSearches]);
+    EXPECT_GT(totals[SearchStat::Evals], 0u);
+    EXPECT_LE(totals[SearchStat::EvalCacheHits], totals[SearchStat::Evals]);
+    EXPECT_NE(output.find("beta cutoffs"), std::string::npos);
+}
+
+TEST(SearchStatsTest, HelperThreadsAreMergedIntoTotals) {
+    uint64_t nodes = runBench("4 2 5");
+
+    // bench counts the nodes of the last info line; helpers search on until they see the stop,
+    // and those nodes are merged too.
+    SearchStats totals = search_stats_totals();
+    EXPECT_GE(totals[SearchStat::Nodes] + totals[SearchStat::QNodes], nodes);
+    EXPECT_GT(totals[SearchStat::TTHits], 0u);
+}
+
+TEST(SearchStatsTest, ResetClearsTotals) {
+    runBench("4 1 3");
+    ASSERT_GT(search_stats_totals()[SearchStat::Nodes], 0u);
+
+    reset_search_stats();
+    SearchStats totals = search_stats_totals();
+    for (int i = 0; i < int(SearchStat::Count); ++i)
+        EXPECT_EQ(totals[SearchStat(i)], 0u) << "counter " << i;
+}
+
+TEST(SearchStatsTest, PrintReportsRatesWithPrefix) {
+    SearchStats stats;
+    stats.add(SearchStat::TTProbes, 200);
+    stats.add(SearchStat::TTHits, 50);
+    stats.add(SearchStat::TTCutoffs, 20);
+
+    std::ostringstream out;
+    print_search_stats(stats, out, "info string ");
+    EXPECT_NE(out.str().find("info string tt probes 200 hits 50 (25.0%) cutoffs 20 (10.0%)"),
+              std::string::npos);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    ::testing::AddGlobalTestEnvironment(new SearchStatsEnvironment());
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "../move.h"
+#include "../timeman.h"
+
+using namespace panda;
+
+static constexpr int OVERHEAD_MS = 20;
+
+// ============================================================
+// Budget from the clock
+// ============================================================
+
+TEST(TimeLimitsTest, MoveTimeIsFixed) {
+    TimeControl tc;
+    tc.moveTimeMs = 1000;
+    TimeLimits limits = compute_time_limits(tc, OVERHEAD_MS);
+    EXPECT_EQ(limits.optimumMs, 980);
+    EXPECT_EQ(limits.maximumMs, 980);
+    EXPECT_TRUE(limits.fixedTime);
+}
+
+TEST(TimeLimitsTest, InfiniteAndNoClockAreUnlimited) {
+    TimeControl tc;
+    tc.infinite = true;
+    tc.timeMs = 60000;
+    EXPECT_EQ(compute_time_limits(tc, OVERHEAD_MS).maximumMs, 0);
+
+    TimeControl none;
+    EXPECT_EQ(compute_time_limits(none, OVERHEAD_MS).maximumMs, 0);
+}
+
+TEST(TimeLimitsTest, SuddenDeathSpendsASmallShare) {
+    TimeControl tc;
+    tc.timeMs = 300000;
+    TimeLimits limits = compute_time_limits(tc, OVERHEAD_MS);
+    EXPECT_GT(limits.optimumMs, 300000 / 60);
+    EXPECT_LT(limits.optimumMs, 300000 / 20);
+    EXPECT_GT(limits.maximumMs, limits.optimumMs);
+    EXPECT_LT(limits.maximumMs, 300000 / 2);
+}
+
+TEST(TimeLimitsTest, IncrementRaisesBudget) {
+    TimeControl tc;
+    tc.timeMs = 60000;
+    TimeControl withInc = tc;
+    withInc.incMs = 1000;
+    EXPECT_GT(compute_time_limits(withInc, OVERHEAD_MS).optimumMs,
+              compute_time_limits(tc, OVERHEAD_MS).optimumMs);
+}
+
+TEST(TimeLimitsTest, MovesToGoSplitsTheClock) {
+    TimeControl tc;
+    tc.timeMs = 100000;
+    tc.movesToGo = 10;
+    TimeLimits ten = compute_time_limits(tc, OVERHEAD_MS);
+    EXPECT_NEAR(ten.optimumMs, 100000 / 10, 100);
+
+    // Last move before the control may use almost the whole clock, but never all of it.
+    tc.movesToGo = 1;
+    TimeLimits last = compute_time_limits(tc, OVERHEAD_MS);
+    EXPECT_GT(last.optimumMs, 90000);
+    EXPECT_LT(last.maximumMs, 100000);
+}
+
+TEST(TimeLimitsTest, NeverExceedsTheClock) {
+    TimeControl tc;
+    tc.timeMs = 100;
+    tc.incMs = 5000;  // a big increment must not tempt us past the clock we have now
+    TimeLimits limits = compute_time_limits(tc, OVERHEAD_MS);
+    EXPECT_GE(limits.optimumMs, 1);
+    EXPECT_LE(limits.optimumMs, limits.maximumMs);
+    EXPECT_LT(limits.maximumMs, 100);
+}
+
+// ============================================================
+// Stopping between iterations (simulated clock)
+// ============================================================
+
+// Runs iterations that each take `iterationMs` until the manager stops; returns the time
+// used. `bestMoveAt` and `scoreAt` describe the iteration results.
+template <typename BestMoveFn, typename ScoreFn>
+static int64_t simulate(const TimeLimits& limits, int64_t iterationMs, double bestMoveShare,
+                        BestMoveFn bestMoveAt, ScoreFn scoreAt) {
+    int64_t now = 0;
+    TimeManager tm(limits, [&now]() { return now; });
+    for (int depth = 1; depth < 100; ++depth) {
+        now += iterationMs;
+        IterationReport report{depth, bestMoveAt(depth), scoreAt(depth),
+                               static_cast<uint64_t>(bestMoveShare * 1000), 1000};
+        if (tm.stop_after_iteration(report))
+            return now;
+    }
+    return now;
+}
+
+TEST(TimeManagerTest, StableBestMoveStopsBeforeOptimum) {
+    TimeLimits limits{1000, 5000};
+    int64_t used = simulate(
+        limits, 50, 0.9, [](int) { return make_move(E2, E4); }, [](int) { return 30; });
+    EXPECT_LT(used, 1000);
+}
+
+TEST(TimeManagerTest, ChangingBestMoveThinksLonger) {
+    TimeLimits limits{1000, 5000};
+    auto score = [](int) { return 30; };
+    int64_t stable = simulate(
+        limits, 50, 0.5, [](int) { return make_move(E2, E4); }, score);
+    int64_t unstable = simulate(
+        limits, 50, 0.5,
+        [](int d) { return (d % 2) ? make_move(E2, E4) : make_move(D2, D4); }, score);
+    EXPECT_GT(unstable, stable);
+    EXPECT_LE(unstable, 5000);
+}
+
+TEST(TimeManagerTest, FallingScoreThinksLonger) {
+    TimeLimits limits{1000, 5000};
+    auto best = [](int) { return make_move(E2, E4); };
+    int64_t steady = simulate(limits, 50, 0.5, best, [](int) { return 0; });
+    int64_t falling = simulate(limits, 50, 0.5, best, [](int d) { return -40 * d; });
+    EXPECT_GT(falling, steady);
+}
+
+TEST(TimeManagerTest, SkipsIterationThatCannotFinish) {
+    // Each iteration takes 1.5 s; after the second (3 s) the next one would end past 5 s.
+    TimeLimits limits{4000, 5000};
+    int64_t used = simulate(
+        limits, 1500, 0.5, [](int) { return make_move(E2, E4); }, [](int) { return 0; });
+    EXPECT_EQ(used, 3000);
+}
+
+TEST(TimeManagerTest, MoveTimeUsesWholeBudget) {
+    // A stable best move and slow iterations would end a clock search early; movetime
+    // keeps going until its hard limit.
+    TimeControl tc;
+    tc.moveTimeMs = 1000;
+    TimeLimits limits = compute_time_limits(tc, 0);
+    int64_t used = simulate(
+        limits, 300, 0.9, [](int) { return make_move(E2, E4); }, [](int) { return 30; });
+    EXPECT_EQ(used, 1200);
+}
+
+TEST(TimeManagerTest, ClampedClockIsNotFixedTime) {
+    // Short on time the clock share cap pulls the optimum down to the maximum. That is
+    // still a clock search: a stable best move stops it before the hard limit.
+    TimeControl tc;
+    tc.timeMs = 1000;
+    tc.incMs = 2000;
+    TimeLimits limits = compute_time_limits(tc, 0);
+    ASSERT_EQ(limits.optimumMs, limits.maximumMs);
+    EXPECT_FALSE(limits.fixedTime);
+    int64_t used = simulate(
+        limits, 100, 0.9, [](int) { return make_move(E2, E4); }, [](int) { return 30; });
+    EXPECT_LT(used, limits.maximumMs);
+}
+
+TEST(TimeManagerTest, UnlimitedNeverStops) {
+    TimeLimits limits{0, 0};
+    int64_t now = 0;
+    TimeManager tm(limits, [&now]() { return now; });
+    for (int depth = 1; depth < 50; ++depth) {
+        now += 10000;
+        IterationReport report{depth, make_move(E2, E4), 0, 900, 1000};
+        EXPECT_FALSE(tm.stop_after_iteration(report));
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
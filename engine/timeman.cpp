@@ -0,0 +1,112 @@
+#include "timeman.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace panda {
+
+static constexpr int MIN_SEARCH_MS = 1;
+static constexpr int SUDDEN_DEATH_HORIZON = 40;  // moves we plan for without movestogo
+static constexpr int MAX_MOVES_TO_GO = 50;
+static constexpr int MAX_OPTIMUM_RATIO = 5;         // maximum may stretch to 5x the optimum
+static constexpr double MAX_CLOCK_SHARE = 0.8;      // of the clock, unless the control ends now
+static constexpr int NEXT_ITERATION_RATIO = 2;      // an iteration costs ~2x the previous one
+
+TimeLimits compute_time_limits(const TimeControl& tc, int moveOverheadMs) {
+    if (tc.moveTimeMs > 0) {
+        // Keep safety overhead so we do not lose on GUI/OS scheduling latency.
+        int t = std::max(tc.moveTimeMs - moveOverheadMs, MIN_SEARCH_MS);
+        return {t, t, true};
+    }
+    if (tc.infinite || tc.timeMs <= 0)
+        return {};
+
+    int mtg = tc.movesToGo > 0 ? std::min(tc.movesToGo, MAX_MOVES_TO_GO) : SUDDEN_DEATH_HORIZON;
+
+    // Time left for the next `mtg` moves: the clock plus the increments still to come,
+    // minus the per-move overhead.
+    int64_t available = int64_t(tc.timeMs) + int64_t(tc.incMs) * (mtg - 1) -
+                        int64_t(moveOverheadMs) * mtg;
+    int64_t optimum = std::max<int64_t>(available / mtg, MIN_SEARCH_MS);
+
+    // Hard cap below the remaining clock. The last move before a control may use all of it.
+    int64_t clockCap = (mtg == 1) ? int64_t(tc.timeMs) - moveOverheadMs
+                                  : int64_t(tc.timeMs * MAX_CLOCK_SHARE) - moveOverheadMs;
+    int64_t maximum = std::min(optimum * MAX_OPTIMUM_RATIO, clockCap);
+    maximum = std::max<int64_t>(maximum, MIN_SEARCH_MS);
+    optimum = std::min(optimum, maximum);
+
+    return {static_cast<int>(optimum), static_cast<int>(maximum)};
+}
+
+TimeManager::TimeManager(const TimeLimits& limits, Clock clock_)
+    : lim(limits),
+      clock(std::move(clock_)),
+      startMs(0),
+      lastIterationEndMs(0),
+      budgetMs(limits.optimumMs),
+      prevBestMove(NullMove),
+      prevScore(0),
+      bestMoveChanges(0.0) {
+    startMs = now_ms();
+}
+
+int64_t TimeManager::now_ms() const {
+    if (clock)
+        return clock();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t TimeManager::elapsed_ms() const {
+    return now_ms() - startMs;
+}
+
+bool TimeManager::stop_after_iteration(const IterationReport& report) {
+    int64_t elapsed = elapsed_ms();
+    int64_t iterationMs = elapsed - lastIterationEndMs;
+    lastIterationEndMs = elapsed;
+
+    // Best-move stability: changes count fully now and half as much per later iteration.
+    bestMoveChanges *= 0.5;
+    if (report.depth > 1 && report.bestMove != prevBestMove)
+        bestMoveChanges += 1.0;
+    double instability = 0.8 + 0.6 * bestMoveChanges;
+
+    // A dropping score means trouble: think longer. A rising one lets us save time.
+    double fallingEval = 1.0;
+    if (report.depth > 1)
+        fallingEval = std::clamp(1.0 + (prevScore - report.score) / 250.0, 0.85, 1.4);
+
+    // If nearly all root nodes went into the best move, the alternatives were refuted
+    // quickly and the choice is clear.
+    double effort = 1.0;
+    if (report.rootNodes > 0) {
+        double share = double(report.bestMoveNodes) / double(report.rootNodes);
+        effort = std::clamp(1.6 - share, 0.7, 1.3);
+    }
+
+    prevBestMove = report.bestMove;
+    prevScore = report.score;
+
+    if (lim.maximumMs <= 0)
+        return false;
+
+    // Fixed-time searches (movetime) keep their whole budget: they are neither scaled nor
+    // stopped early, and only the hard limit ends them. Clock limits can come out equal
+    // too (the clock share cap, movestogo 1) and still scale.
+    if (lim.fixedTime)
+        return elapsed >= lim.maximumMs;
+
+    budgetMs = std::min<int64_t>(
+        static_cast<int64_t>(lim.optimumMs * instability * fallingEval * effort),
+        lim.maximumMs);
+    if (elapsed >= budgetMs)
+        return true;
+
+    // The next iteration would be cut off by the hard limit before finishing.
+    return elapsed + NEXT_ITERATION_RATIO * iterationMs > lim.maximumMs;
+}
+
+}  // namespace panda
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "move.h"
+
+namespace panda {
+
+// Clock situation of the side to move, as given by "go".
+struct TimeControl {
+    int timeMs = 0;      // remaining clock; 0 = no clock
+    int incMs = 0;       // increment per move
+    int movesToGo = 0;   // moves until the next time control; 0 = sudden death
+    int moveTimeMs = 0;  // fixed time for this move ("go movetime")
+    bool infinite = false;
+};
+
+// Budget for one move. The search aims to stop between iterations around `optimumMs` and
+// never runs past `maximumMs`. Zero means unlimited.
+struct TimeLimits {
+    int optimumMs = 0;
+    int maximumMs = 0;
+    bool fixedTime = false;  // fixed budget ("go movetime"): never scaled down
+};
+
+TimeLimits compute_time_limits(const TimeControl& tc, int moveOverheadMs);
+
+// Root statistics of one completed iteration.
+struct IterationReport {
+    int depth;
+    Move bestMove;
+    int score;
+    uint64_t bestMoveNodes;  // nodes spent searching the best root move
+    uint64_t rootNodes;      // nodes spent on all root moves
+};
+
+// Decides between iterations whether to start another one. The optimum is scaled up when
+// the best move keeps changing, the score is dropping, or the best move took only a small
+// share of the root nodes, and scaled down in the opposite cases.
+class TimeManager {
+   public:
+    // Milliseconds on any monotonic scale; tests pass a simulated clock.
+    using Clock = std::function<int64_t()>;
+
+    explicit TimeManager(const TimeLimits& limits, Clock clock = nullptr);
+
+    int64_t elapsed_ms() const;
+    const TimeLimits& limits() const {
+        return lim;
+    }
+    // Optimum after the scaling applied by the last stop_after_iteration() call.
+    int64_t budget_ms() const {
+        return budgetMs;
+    }
+
+    // True when the next iteration should not be started.
+    bool stop_after_iteration(const IterationReport& report);
+
+   private:
+    int64_t now_ms() const;
+
+    TimeLimits lim;
+    Clock clock;
+    int64_t startMs;
+    int64_t lastIterationEndMs;
+    int64_t budgetMs;
+    Move prevBestMove;
+    int prevScore;
+    double bestMoveChanges;  // decaying count of recent best-move changes
+};
+
+}  // namespace panda
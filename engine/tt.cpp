@@ -1,93 +1,245 @@
 #include "tt.h"
 
 #include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 namespace panda {
 
-TranspositionTable::TranspositionTable(size_t sizeMB) {
-    size_t entryCount = (sizeMB * 1024 * 1024) / sizeof(TTEntry);
+static constexpr uint8_t GENERATION_MASK = 0x3F;  // 6-bit generation counter
+
+// Decoded copy of one slot word.
+struct TTSlot {
+    uint16_t key16;
+    Move bestMove;
+    int16_t score;
+    uint8_t depth8;
+    uint8_t genBound;
+
+    int depth() const { return depth8 - 1; }
+    TTFlag flag() const { return static_cast<TTFlag>(genBound & 0x3); }
+    uint8_t generation() const { return genBound >> 2; }
+};
+
+static uint16_t key_check(uint64_t key) {
+    return static_cast<uint16_t>(key >> 48);
+}
+
+static TTSlot unpack(uint64_t word) {
+    TTSlot slot;
+    slot.key16 = static_cast<uint16_t>(word);
+    slot.bestMove = static_cast<Move>(word >> 16);
+    slot.score = static_cast<int16_t>(static_cast<uint16_t>(word >> 32));
+    slot.depth8 = static_cast<uint8_t>(word >> 48);
+    slot.genBound = static_cast<uint8_t>(word >> 56);
+    return slot;
+}
+
+static uint64_t pack(uint64_t key, int score, int depth, TTFlag flag, Move bestMove,
+                     uint8_t generation) {
+    uint16_t score16 = static_cast<uint16_t>(std::clamp(score, INT16_MIN, INT16_MAX));
+    uint8_t depth8 = static_cast<uint8_t>(std::clamp(depth + 1, 1, UINT8_MAX));
+    uint8_t genBound = static_cast<uint8_t>((generation << 2) | flag);
+    return uint64_t(key_check(key)) | (uint64_t(bestMove) << 16) | (uint64_t(score16) << 32) |
+           (uint64_t(depth8) << 48) | (uint64_t(genBound) << 56);
+}
+
+// Tables of at least this size are aligned to it so the kernel can back them with
+// transparent huge pages, which cuts TLB misses on random probes.
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Tables below this size are cleared on the calling thread; spawning helpers costs more.
+static constexpr size_t PARALLEL_CLEAR_BYTES = 16 * 1024 * 1024;
+
+// Returns uninitialized memory; nothing is touched until clear() runs.
+static TTBucket* alloc_buckets(size_t count) {
+    size_t bytes = count * sizeof(TTBucket);
+    size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : alignof(TTBucket);
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+
+#if defined(_WIN32)
+    void* mem = _aligned_malloc(bytes, alignment);
+#else
+    void* mem = std::aligned_alloc(alignment, bytes);
+#endif
+    if (!mem)
+        throw std::bad_alloc();
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (alignment == HUGE_PAGE_SIZE)
+        madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+    return static_cast<TTBucket*>(mem);
+}
+
+void TTBucketDeleter::operator()(TTBucket* buckets) const {
+#if defined(_WIN32)
+    _aligned_free(buckets);
+#else
+    std::free(buckets);
+#endif
+}
+
+TranspositionTable::TranspositionTable(size_t sizeMB, int threadCount) {
+    resize(sizeMB, threadCount);
+}
+
+void TranspositionTable::resize(size_t sizeMB, int threadCount) {
+    size_t maxBuckets = (sizeMB * 1024 * 1024) / sizeof(TTBucket);
     // Round down to nearest power of 2
     size_t size = 1;
-    while (size * 2 <= entryCount) size *= 2;
-    table.resize(size);
+    while (size * 2 <= maxBuckets) size *= 2;
+
+    // The bookkeeping is only set once a table exists to describe: while an allocation can
+    // still throw, the table is empty rather than sized for memory that is already freed.
+    const size_t oldSize = bucketCount;
+    table.reset();
+    bucketCount = 0;
+    mask = 0;
+    try {
+        table.reset(alloc_buckets(size));
+    } catch (const std::bad_alloc&) {
+        // Get a table back so the engine can keep searching, then report. If the old size no
+        // longer fits either, fall back to a single bucket: probe() and store() never check
+        // for a missing table.
+        if (oldSize == 0)
+            throw;
+        size_t fallback = oldSize;
+        try {
+            table.reset(alloc_buckets(fallback));
+        } catch (const std::bad_alloc&) {
+            fallback = 1;
+            table.reset(alloc_buckets(fallback));
+        }
+        bucketCount = fallback;
+        mask = fallback - 1;
+        clear(threadCount);
+        throw;
+    }
+    bucketCount = size;
     mask = size - 1;
-    currentGeneration = 1;
-    clear();
+    clear(threadCount);
 }
 
 void TranspositionTable::new_search() {
-    ++currentGeneration;
-    if (currentGeneration == 0)
-        currentGeneration = 1;
+    currentGeneration = (currentGeneration + 1) & GENERATION_MASK;
 }
 
 void TranspositionTable::store(uint64_t key, int score, int depth, TTFlag flag, Move bestMove) {
-    TTEntry& entry = table[key & mask];
+    TTBucket& bucket = table[key & mask];
+    uint16_t key16 = key_check(key);
+    uint64_t word = pack(key, score, depth, flag, bestMove, currentGeneration);
+
+    // Slots fill front to back and are never emptied again, so an empty slot means the
+    // key is not further along in the bucket either. Another thread may write the bucket
+    // while we scan it; the worst outcome is a lost or duplicated entry, never a torn one.
+    int victimIdx = 0;
+    int victimWorth = INT_MAX;
+    TTSlot victim{};
+    for (int i = 0; i < TT_BUCKET_SLOTS; ++i) {
+        TTSlot slot = unpack(bucket.slots[i].load(std::memory_order_relaxed));
+
+        // Rule A: empty slot
+        if (slot.depth8 == 0) {
+            bucket.slots[i].store(word, std::memory_order_relaxed);
+            return;
+        }
 
-    bool replace = false;
-
-    // Rule A: empty slot
-    if (entry.key == 0) {
-        replace = true;
-    } else if (entry.key == key) {
         // Rule B: same key
-        replace = (depth >= entry.depth) || (flag == TT_EXACT);
-    } else {
-        // Rule C: different key (collision)
-        uint8_t age = static_cast<uint8_t>(currentGeneration - entry.generation);
-        bool stale = age >= 2;
-        replace = stale || (depth > entry.depth) ||
-                  (depth == entry.depth && flag == TT_EXACT && entry.flag != TT_EXACT);
+        if (slot.key16 == key16) {
+            if (depth >= slot.depth() || flag == TT_EXACT)
+                bucket.slots[i].store(word, std::memory_order_relaxed);
+            return;
+        }
+
+        // Least valuable slot: shallow and old entries go first.
+        int age = (currentGeneration - slot.generation()) & GENERATION_MASK;
+        int worth = slot.depth8 - 8 * age;
+        if (worth < victimWorth) {
+            victimWorth = worth;
+            victimIdx = i;
+            victim = slot;
+        }
     }
 
-    if (!replace)
-        return;
+    // Rule C: bucket full, compete with its least valuable entry
+    int age = (currentGeneration - victim.generation()) & GENERATION_MASK;
+    bool stale = age >= 2;
+    bool replace = stale || (depth > victim.depth()) ||
+                   (depth == victim.depth() && flag == TT_EXACT && victim.flag() != TT_EXACT);
 
     // Rule D: write replacement
-    entry.key = key;
-    entry.score = score;
-    entry.depth = depth;
-    entry.flag = flag;
-    entry.bestMove = bestMove;
-    entry.generation = currentGeneration;
+    if (replace)
+        bucket.slots[victimIdx].store(word, std::memory_order_relaxed);
 }
 
 bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
-    const TTEntry& stored = table[key & mask];
-    if (stored.key == key) {
-        entry = stored;
-        return true;
+    const TTBucket& bucket = table[key & mask];
+    uint16_t key16 = key_check(key);
+
+    for (const auto& atomicSlot : bucket.slots) {
+        TTSlot slot = unpack(atomicSlot.load(std::memory_order_relaxed));
+        if (slot.depth8 == 0)
+            return false;
+        if (slot.key16 == key16) {
+            entry.key = key;
+            entry.score = slot.score;
+            entry.depth = slot.depth();
+            entry.flag = slot.flag();
+            entry.bestMove = slot.bestMove;
+            entry.generation = slot.generation();
+            return true;
+        }
     }
     return false;
 }
 
-void TranspositionTable::clear() {
-    currentGeneration = 1;
-    for (auto& entry : table) {
-        entry.key = 0;
-        entry.score = 0;
-        entry.depth = 0;
-        entry.flag = TT_EXACT;
-        entry.bestMove = NullMove;
-        entry.generation = 0;
+void TranspositionTable::clear(int threadCount) {
+    currentGeneration = 0;
+
+    // An all-zero slot word is an empty slot.
+    auto clearStripe = [this](size_t begin, size_t end) {
+        std::memset(static_cast<void*>(table.get() + begin), 0, (end - begin) * sizeof(TTBucket));
+    };
+
+    if (threadCount <= 1 || bucketCount * sizeof(TTBucket) < PARALLEL_CLEAR_BYTES) {
+        clearStripe(0, bucketCount);
+        return;
+    }
+
+    size_t stripe = (bucketCount + threadCount - 1) / threadCount;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (int t = 0; t < threadCount; ++t) {
+        size_t begin = std::min(bucketCount, t * stripe);
+        size_t end = std::min(bucketCount, begin + stripe);
+        workers.emplace_back(clearStripe, begin, end);
     }
+    for (auto& worker : workers) worker.join();
 }
 
 int TranspositionTable::hashfull_permille(size_t sampleSize) const {
-    if (table.empty())
-        return 0;
-
-    size_t sample = std::min(sampleSize, table.size());
+    size_t sample = std::min(sampleSize, bucketCount);
     if (sample == 0)
         return 0;
 
     size_t used = 0;
     for (size_t i = 0; i < sample; ++i) {
-        if (table[i].key != 0)
-            ++used;
+        for (const auto& slot : table[i].slots) {
+            if (unpack(slot.load(std::memory_order_relaxed)).depth8 != 0)
+                ++used;
+        }
     }
 
-    return static_cast<int>((used * 1000) / sample);
+    return static_cast<int>((used * 1000) / (sample * TT_BUCKET_SLOTS));
 }
 
 }  // namespace panda
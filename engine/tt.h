@@ -1,10 +1,16 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <memory>
 
 #include "move.h"
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
 namespace panda {
 
 enum TTFlag : uint8_t {
@@ -13,8 +19,9 @@ enum TTFlag : uint8_t {
     TT_BETA    // lower bound
 };
 
+// Unpacked view of a table entry, filled in by probe().
 struct TTEntry {
-    uint64_t key;  // full Zobrist hash for collision detection
+    uint64_t key;  // the probed key (only its upper 16 bits were verified)
     int score;
     int depth;
     TTFlag flag;
@@ -22,19 +29,63 @@ struct TTEntry {
     uint8_t generation;
 };
 
+constexpr int TT_BUCKET_SLOTS = 4;
+
+// Each slot is one 64-bit word, read and written with single relaxed atomic accesses, so
+// threads sharing the table never see half of one store and half of another. Layout:
+//   bits  0-15  upper 16 bits of the Zobrist key
+//   bits 16-31  best move
+//   bits 32-47  score (int16)
+//   bits 48-55  depth + 1; 0 marks an empty slot
+//   bits 56-63  generation << 2 | flag
+// Four slots fill one 32-byte aligned bucket: a probe touches a single cache line.
+struct alignas(32) TTBucket {
+    std::atomic<uint64_t> slots[TT_BUCKET_SLOTS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "TT slots must be lock-free");
+static_assert(sizeof(TTBucket) == 32, "TTBucket must stay 32 bytes");
+
+// Releases bucket memory obtained from the TT's large-page allocator.
+struct TTBucketDeleter {
+    void operator()(TTBucket* buckets) const;
+};
+
+// Shared by all search threads without locks. A probe sees either a whole slot or
+// nothing; a hit whose 16-bit key check matched a different position is still possible,
+// so callers must validate the move before playing it.
 class TranspositionTable {
    public:
-    explicit TranspositionTable(size_t sizeMB = 64);
+    explicit TranspositionTable(size_t sizeMB = 64, int threadCount = 1);
+
+    // Frees the current table before allocating the new one, so peak memory is one table.
+    // Throws std::bad_alloc if the new size cannot be allocated. The old size is then
+    // allocated again (empty), or a single bucket if even that fails.
+    void resize(size_t sizeMB, int threadCount = 1);
 
     void new_search();
     void store(uint64_t key, int score, int depth, TTFlag flag, Move bestMove);
     bool probe(uint64_t key, TTEntry& entry) const;
-    void clear();
+
+    // Starts pulling the bucket for `key` into cache so a later probe() does not stall.
+    void prefetch(uint64_t key) const {
+#if defined(_MSC_VER)
+        _mm_prefetch(reinterpret_cast<const char*>(&table[key & mask]), _MM_HINT_T0);
+#else
+        __builtin_prefetch(&table[key & mask]);
+#endif
+    }
+
+    // Zeroes the table using `threadCount` threads, each clearing one contiguous stripe.
+    // Pages are first touched here, so the kernel places each stripe on the NUMA node of
+    // the thread that cleared it.
+    void clear(int threadCount = 1);
     int hashfull_permille(size_t sampleSize = 1000) const;
 
    private:
-    std::vector<TTEntry> table;
-    size_t mask;  // size - 1, for fast modulo (size is power of 2)
+    std::unique_ptr<TTBucket[], TTBucketDeleter> table;
+    size_t bucketCount = 0;
+    size_t mask = 0;  // bucket count - 1, for fast modulo (bucket count is power of 2)
     uint8_t currentGeneration;
 };
 
@@ -1,18 +1,27 @@
 #include "uci.h"
 
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <new>
 #include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "attacks.h"
+#include "bench.h"
 #include "board.h"
 #include "eval.h"
 #include "move.h"
 #include "movegen.h"
+#include "nnue/panda_nnue.h"
+#include "perft.h"
 #include "search.h"
+#include "search_stats.h"
+#include "timeman.h"
 #include "tt.h"
 #include "zobrist.h"
 
@@ -21,7 +30,6 @@ namespace panda {
 static const char* ENGINE_NAME = "PandaChess";
 static const char* ENGINE_AUTHOR = "PandaChess Team";
 static constexpr int MOVE_OVERHEAD_MS = 20;
-static constexpr int MIN_SEARCH_MS = 1;
 
 // Parse a UCI move string (e.g. "e2e4", "e7e8q") and match against legal moves
 static Move parseUCIMove(const Board& board, const std::string& str) {
@@ -116,10 +124,70 @@ static void parsePosition(Board& board, std::istringstream& iss, std::vector<uin
     }
 }
 
+// Runs "go" searches (and perft) on one thread that lives as long as the UCI loop, so a move
+// does not pay for starting a thread and the input loop stays free to read "stop". One job
+// at a time: start() follows a wait().
+class SearchRunner {
+   public:
+    SearchRunner() : thread([this]() { loop(); }) {}
+
+    ~SearchRunner() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+
+    void start(std::function<void()> search) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = std::move(search);
+            busy = true;
+        }
+        wake.notify_all();
+    }
+
+    // Raises the stop flag if a search is running and waits for it to finish
+    void stop(std::atomic<bool>& stopFlag) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!busy)
+            return;
+        stopFlag.store(true, std::memory_order_relaxed);
+        done.wait(lock, [this]() { return !busy; });
+    }
+
+   private:
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this]() { return quit || job; });
+            if (quit)
+                return;
+            std::function<void()> search = std::move(job);
+            job = nullptr;
+            lock.unlock();
+            search();
+            lock.lock();
+            busy = false;
+            done.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void()> job;
+    bool busy = false;
+    bool quit = false;
+    std::thread thread;  // last, so it starts after the members it uses
+};
+
 // Handle "go" command
 static void parseGoAndSearch(const Board& board, const std::vector<uint64_t>& history,
                              std::istringstream& iss, TranspositionTable& tt,
-                             std::atomic<bool>& stopFlag, std::thread& searchThread,
+                             std::atomic<bool>& stopFlag, SearchRunner& searchRunner,
                              int numThreads) {
     int wtime = 0, btime = 0, winc = 0, binc = 0;
     int movetime = 0;
@@ -147,30 +215,15 @@ static void parseGoAndSearch(const Board& board, const std::vector<uint64_t>& hi
             infinite = true;
     }
 
-    // Calculate time to search
-    int timeLimitMs = 0;
-    if (movetime > 0) {
-        // Keep safety overhead so we do not lose on GUI/OS scheduling latency.
-        timeLimitMs = movetime - MOVE_OVERHEAD_MS;
-        if (timeLimitMs < MIN_SEARCH_MS)
-            timeLimitMs = MIN_SEARCH_MS;
-    } else if (!infinite && (wtime > 0 || btime > 0)) {
-        // Simple time management: use a share of remaining time + increment.
-        int myTime = (board.side_to_move() == White) ? wtime : btime;
-        int myInc = (board.side_to_move() == White) ? winc : binc;
-        int divisor = (movestogo > 0) ? movestogo : 30;
-        timeLimitMs = myTime / divisor + (myInc * 3) / 4;
-
-        // Hard cap below remaining clock to preserve move-overhead safety.
-        int maxTime = myTime - MOVE_OVERHEAD_MS;
-        if (maxTime < MIN_SEARCH_MS)
-            maxTime = MIN_SEARCH_MS;
-        if (timeLimitMs > maxTime)
-            timeLimitMs = maxTime;
-        if (timeLimitMs < MIN_SEARCH_MS)
-            timeLimitMs = MIN_SEARCH_MS;
-    }
-    // If infinite or no time control: timeLimitMs stays 0 (no limit)
+    // Budget for this move from the side to move's clock
+    TimeControl tc;
+    tc.timeMs = (board.side_to_move() == White) ? wtime : btime;
+    tc.incMs = (board.side_to_move() == White) ? winc : binc;
+    tc.movesToGo = movestogo;
+    tc.moveTimeMs = movetime;
+    tc.infinite = infinite;
+    TimeLimits limits = compute_time_limits(tc, MOVE_OVERHEAD_MS);
+    // If infinite or no time control: limits stay 0 (no limit)
 
     int maxDepth = (depth > 0) ? depth : MAX_PLY;
 
@@ -179,8 +232,8 @@ static void parseGoAndSearch(const Board& board, const std::vector<uint64_t>& hi
     std::vector<uint64_t> searchHistory = history;
     stopFlag.store(false, std::memory_order_relaxed);
 
-    searchThread = std::thread([searchBoard, searchHistory, timeLimitMs, maxDepth, numThreads, &tt,
-                                &stopFlag]() {
+    searchRunner.start([searchBoard, searchHistory, limits, maxDepth, numThreads, &tt,
+                        &stopFlag]() {
         auto infoCb = [&tt](const SearchInfo& info) {
             std::cout << "info depth " << info.depth;
             if (info.isMate) {
@@ -202,8 +255,8 @@ static void parseGoAndSearch(const Board& board, const std::vector<uint64_t>& hi
             std::cout << std::endl;
         };
 
-        SearchResult result = search(searchBoard, timeLimitMs, maxDepth, tt, stopFlag,
-                                     searchHistory, numThreads, infoCb);
+        SearchResult result = search(searchBoard, limits, maxDepth, tt, stopFlag, searchHistory,
+                                     numThreads, infoCb);
 
         if (result.bestMove == NullMove) {
             std::cout << "bestmove 0000" << std::endl;
@@ -213,6 +266,23 @@ static void parseGoAndSearch(const Board& board, const std::vector<uint64_t>& hi
     });
 }
 
+// Loads the NNUE nets, sizes the per-thread accumulator caches and starts the parked search
+// helpers off the UCI thread, so the first search does not pay for them. "isready" and "go"
+// wait for it to finish.
+static void startNnueWarmup(std::thread& warmupThread, int numThreads) {
+    if (warmupThread.joinable())
+        warmupThread.join();
+    warmupThread = std::thread([numThreads]() {
+        nnue::preallocate_contexts(numThreads);
+        set_search_threads(numThreads);
+    });
+}
+
+static void finishNnueWarmup(std::thread& warmupThread) {
+    if (warmupThread.joinable())
+        warmupThread.join();
+}
+
 void uci_loop() {
     // Initialize engine tables
     attacks::init();
@@ -224,9 +294,11 @@ void uci_loop() {
 
     TranspositionTable tt(64);  // 64 MB default
     std::atomic<bool> stopFlag{false};
-    std::thread searchThread;
+    SearchRunner searchRunner;
     int numThreads = 4;
     set_eval_mode(EvalMode::NNUE);
+    std::thread warmupThread;
+    startNnueWarmup(warmupThread, numThreads);
 
     std::string line;
     while (std::getline(std::cin, line)) {
@@ -242,16 +314,16 @@ void uci_loop() {
                       << " min 1 max 256" << std::endl;
             std::cout << "option name Eval type combo default NNUE var NNUE var Handcrafted"
                       << std::endl;
+            std::cout << "info string NNUE kernel " << nnue::kernel_name() << std::endl;
             std::cout << "uciok" << std::endl;
         } else if (cmd == "isready") {
+            finishNnueWarmup(warmupThread);
             std::cout << "readyok" << std::endl;
         } else if (cmd == "ucinewgame") {
             // Wait for any running search to finish
-            if (searchThread.joinable()) {
-                stopFlag.store(true, std::memory_order_relaxed);
-                searchThread.join();
-            }
-            tt.clear();
+            searchRunner.stop(stopFlag);
+            tt.clear(numThreads);
+            clear_search_heuristics();
             board.set_fen(StartFEN);
             history.clear();
             history.push_back(board.hash_key());
@@ -259,15 +331,11 @@ void uci_loop() {
             parsePosition(board, iss, history);
         } else if (cmd == "go") {
             // Wait for any previous search to finish
-            if (searchThread.joinable()) {
-                stopFlag.store(true, std::memory_order_relaxed);
-                searchThread.join();
-            }
-            parseGoAndSearch(board, history, iss, tt, stopFlag, searchThread, numThreads);
+            searchRunner.stop(stopFlag);
+            finishNnueWarmup(warmupThread);
+            parseGoAndSearch(board, history, iss, tt, stopFlag, searchRunner, numThreads);
         } else if (cmd == "stop") {
-            stopFlag.store(true, std::memory_order_relaxed);
-            if (searchThread.joinable())
-                searchThread.join();
+            searchRunner.stop(stopFlag);
         } else if (cmd == "setoption") {
             std::string token;
             iss >> token;  // "name"
@@ -283,34 +351,65 @@ void uci_loop() {
                         sizeMB = 1;
                     if (sizeMB > 4096)
                         sizeMB = 4096;
-                    tt = TranspositionTable(static_cast<size_t>(sizeMB));
+                    // The table must not be freed under a running search
+                    searchRunner.stop(stopFlag);
+                    try {
+                        tt.resize(static_cast<size_t>(sizeMB), numThreads);
+                    } catch (const std::bad_alloc&) {
+                        std::cout << "info string could not allocate " << sizeMB
+                                  << " MB for Hash, keeping the previous size" << std::endl;
+                    }
                 } else if (name == "Threads") {
                     int threads = std::stoi(value);
                     if (threads < 1)
                         threads = 1;
                     if (threads > 256)
                         threads = 256;
+                    // The helper pool is resized, which waits for a running search
+                    searchRunner.stop(stopFlag);
                     numThreads = threads;
+                    startNnueWarmup(warmupThread, numThreads);
                 } else if (name == "Eval") {
                     EvalMode mode;
                     if (parse_eval_mode(value, mode))
                         set_eval_mode(mode);
                 }
             }
-        } else if (cmd == "quit") {
-            if (searchThread.joinable()) {
-                stopFlag.store(true, std::memory_order_relaxed);
-                searchThread.join();
+        } else if (cmd == "bench") {
+            searchRunner.stop(stopFlag);
+            finishNnueWarmup(warmupThread);
+            bench(iss, std::cout);
+        } else if (cmd == "debug") {
+            // "debug stats [reset]": search counters of finished searches
+            std::string what, action;
+            iss >> what >> action;
+            if (what == "stats") {
+                if (action == "reset")
+                    reset_search_stats();
+                else
+                    print_search_stats(search_stats_totals(), std::cout, "info string ");
             }
+        } else if (cmd == "perft" || cmd == "divide") {
+            // Deep counts take minutes; run them like a search so "stop" and "quit" end them
+            searchRunner.stop(stopFlag);
+            std::string perftArgs;
+            std::getline(iss, perftArgs);
+            Board perftBoard = board;
+            const bool divide = cmd == "divide";
+            stopFlag.store(false, std::memory_order_relaxed);
+            searchRunner.start([perftBoard, perftArgs, divide, &stopFlag]() {
+                std::istringstream args(perftArgs);
+                perft_command(perftBoard, args, std::cout, divide, &stopFlag);
+            });
+        } else if (cmd == "quit") {
+            searchRunner.stop(stopFlag);
             break;
         }
     }
 
     // ADDED: Cleanup when exiting loop (EOF or error)
-    if (searchThread.joinable()) {
-        stopFlag.store(true, std::memory_order_relaxed);
-        searchThread.join();
-    }
+    searchRunner.stop(stopFlag);
+    finishNnueWarmup(warmupThread);
 }
 
 }  // namespace panda